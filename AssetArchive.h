@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include "MappedFile.h"
+
+// Layout: ArchiveHeader, entryCount ArchiveEntry records sorted by name, the name table,
+// then every payload aligned to ArchiveAlignment
+struct ArchiveHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t nameTableSize;
+};
+
+struct ArchiveEntry {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+constexpr char ArchiveMagic[4] = { 'T', 'C', 'P', 'K' };
+constexpr uint32_t ArchiveVersion = 1;
+constexpr uint64_t ArchiveAlignment = 16;
+
+class AssetArchive {
+private:
+	MappedFile file;
+	const uint8_t* data;
+	std::size_t dataSize;
+	const ArchiveEntry* entries;
+	const char* names;
+	uint32_t entryCount;
+
+	bool Validate() {
+		if (dataSize < sizeof(ArchiveHeader)) return false;
+
+		const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(data);
+		if (std::memcmp(header->magic, ArchiveMagic, sizeof(ArchiveMagic)) != 0 || header->version != ArchiveVersion) return false;
+
+		uint64_t indexEnd = sizeof(ArchiveHeader) + (uint64_t)header->entryCount * sizeof(ArchiveEntry) + header->nameTableSize;
+		if (indexEnd > dataSize) return false;
+
+		entryCount = header->entryCount;
+		entries = reinterpret_cast<const ArchiveEntry*>(data + sizeof(ArchiveHeader));
+		names = reinterpret_cast<const char*>(entries + entryCount);
+
+		for (uint32_t i = 0; i < entryCount; i++) {
+			// Written so that no sum can wrap around
+			if (entries[i].offset > dataSize || entries[i].size > dataSize - entries[i].offset) return false;
+			if ((uint64_t)entries[i].nameOffset + entries[i].nameLength > header->nameTableSize) return false;
+		}
+
+		return true;
+	}
+
+	int CompareName(const ArchiveEntry& entry, const char* name, std::size_t length) const {
+		int result = std::memcmp(names + entry.nameOffset, name, (std::min<std::size_t>)(entry.nameLength, length));
+		if (result != 0) return result;
+		return entry.nameLength < length ? -1 : (entry.nameLength > length ? 1 : 0);
+	}
+public:
+	AssetArchive() {
+		data = nullptr;
+		dataSize = 0;
+		entries = nullptr;
+		names = nullptr;
+		entryCount = 0;
+	}
+
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	// Maps the whole archive read-only; payloads are handed out as pointers into the mapping
+	bool Open(const std::string& filepath) {
+		Close();
+
+		if (!file.Open(filepath)) return false;
+
+		data = file.GetData();
+		dataSize = file.GetSize();
+
+		if (!Validate()) {
+			std::cout << "Couldn't open the asset archive " << filepath << std::endl;
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Close() {
+		file.Close();
+		data = nullptr;
+		dataSize = 0;
+		entries = nullptr;
+		names = nullptr;
+		entryCount = 0;
+	}
+
+	inline bool IsOpen() const { return data != nullptr; }
+	inline uint32_t GetEntryCount() const { return entryCount; }
+
+	// Binary search over the sorted index; returns false if the name is not packed
+	bool Find(const std::string& name, const void*& payload, std::size_t& size) const {
+		uint32_t low = 0, high = entryCount;
+		while (low < high) {
+			uint32_t mid = low + (high - low) / 2;
+			int result = CompareName(entries[mid], name.data(), name.size());
+
+			if (result == 0) {
+				payload = data + entries[mid].offset;
+				size = (std::size_t)entries[mid].size;
+				return true;
+			}
+
+			if (result < 0) low = mid + 1;
+			else high = mid;
+		}
+
+		return false;
+	}
+
+	static bool Write(const std::string& filepath, std::vector<std::pair<std::string, std::vector<uint8_t>>> files) {
+		std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+		ArchiveHeader header;
+		std::memcpy(header.magic, ArchiveMagic, sizeof(ArchiveMagic));
+		header.version = ArchiveVersion;
+		header.entryCount = (uint32_t)files.size();
+		header.nameTableSize = 0;
+
+		std::vector<ArchiveEntry> index(files.size());
+		std::string nameTable;
+		for (std::size_t i = 0; i < files.size(); i++) {
+			index[i].nameOffset = (uint32_t)nameTable.size();
+			index[i].nameLength = (uint32_t)files[i].first.size();
+			nameTable += files[i].first;
+		}
+		header.nameTableSize = (uint32_t)nameTable.size();
+
+		auto align = [](uint64_t offset) { return (offset + ArchiveAlignment - 1) & ~(ArchiveAlignment - 1); };
+
+		uint64_t offset = align(sizeof(ArchiveHeader) + index.size() * sizeof(ArchiveEntry) + nameTable.size());
+		for (std::size_t i = 0; i < files.size(); i++) {
+			index[i].offset = offset;
+			index[i].size = files[i].second.size();
+			offset = align(offset + index[i].size);
+		}
+
+		std::ofstream writer(filepath, std::ios::binary);
+		if (!writer.is_open()) return false;
+
+		writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		writer.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(ArchiveEntry));
+		writer.write(nameTable.data(), nameTable.size());
+
+		const char padding[ArchiveAlignment] = {};
+		uint64_t written = sizeof(ArchiveHeader) + index.size() * sizeof(ArchiveEntry) + nameTable.size();
+		for (std::size_t i = 0; i < files.size(); i++) {
+			writer.write(padding, index[i].offset - written);
+			writer.write(reinterpret_cast<const char*>(files[i].second.data()), files[i].second.size());
+			written = index[i].offset + index[i].size;
+		}
+
+		return writer.good();
+	}
+};
@@ -2,48 +2,161 @@
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Audio/SoundBuffer.hpp>
+#include "ThreadPool.h"
+#include "AssetArchive.h"
 #include <unordered_map>
+#include <vector>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <atomic>
+#include <future>
 #include <iostream>
 
+template<typename Asset>
+struct AssetHandle {
+	static constexpr uint32_t Invalid = 0xFFFFFFFF;
+	uint32_t id = Invalid;
+
+	inline bool IsValid() const { return id != Invalid; }
+	bool operator==(const AssetHandle& other) const { return id == other.id; }
+	bool operator!=(const AssetHandle& other) const { return id != other.id; }
+};
+
 template<typename Asset>
 class AssetManager {
 private:
-	std::unordered_map<std::string, Asset*> assets;
+	enum LoadStatus : uint8_t {
+		Loading = 0,
+		Loaded = 1,
+		Failed = 2
+	};
+
+	struct Entry {
+		Asset asset;
+		std::string name;
+		std::atomic<uint8_t> status;
+		std::shared_future<void> loading;
+
+		Entry(const std::string& name) : name(name), status(Loading) {}
+	};
+
+	std::vector<std::unique_ptr<Entry>> assets;
+	std::unordered_map<std::string, uint32_t> assetIds;
+
+	static void Load(Entry& entry, const std::string& filepath, const void* memory, std::size_t memorySize) {
+		bool isLoaded = memory ? entry.asset.loadFromMemory(memory, memorySize) : entry.asset.loadFromFile(filepath);
+		if (!isLoaded) {
+			std::cout << "Couldn't load the asset " << entry.name << std::endl;
+			entry.status.store(Failed, std::memory_order_release);
+			return;
+		}
+
+		entry.status.store(Loaded, std::memory_order_release);
+	}
+
+	const Entry& GetEntry(AssetHandle<Asset> handle) const {
+		if (handle.id >= assets.size()) {
+			throw std::out_of_range("Invalid asset handle");
+		}
+
+		return *assets[handle.id];
+	}
 public:
 	AssetManager() {}
 
-	bool LoadAsset(const std::string& assetName, const std::string& filepath) {
-		Asset* asset = new Asset();
-		if (!asset->loadFromFile(filepath)) {
-			std::cout << "Couldn't load the asset " << assetName << std::endl;
-			delete asset;
-			return false;
+	// Names are interned once at load time; a name that is already registered returns its existing handle.
+	// With a pool the file is decoded on a worker and the handle is usable immediately, but not ready.
+	// A load that fails keeps its handle: IsFailed reports it and GetAsset throws.
+	// A non-null memory block is decoded in place instead of opening filepath and must outlive the asset
+	AssetHandle<Asset> LoadAsset(const std::string& assetName, const std::string& filepath, ThreadPool* pool = nullptr, const void* memory = nullptr, std::size_t memorySize = 0) {
+		auto it = assetIds.find(assetName);
+		if (it != assetIds.end()) return AssetHandle<Asset>{ it->second };
+
+		std::unique_ptr<Entry> entry = std::make_unique<Entry>(assetName);
+		Entry* loadingEntry = entry.get();
+
+		if (pool) {
+			entry->loading = pool->Submit([loadingEntry, filepath, memory, memorySize] { Load(*loadingEntry, filepath, memory, memorySize); }).share();
+		}
+		else {
+			Load(*loadingEntry, filepath, memory, memorySize);
 		}
 
-		assets.insert(std::make_pair(assetName, asset));
-		return true;
+		AssetHandle<Asset> handle{ (uint32_t)assets.size() };
+		assets.push_back(std::move(entry));
+		assetIds.insert(std::make_pair(assetName, handle.id));
+		return handle;
+	}
+
+	AssetHandle<Asset> GetHandle(const std::string& assetName) const {
+		auto it = assetIds.find(assetName);
+		if (it == assetIds.end()) {
+			throw std::out_of_range("Asset " + assetName + " is not registered");
+		}
+
+		return AssetHandle<Asset>{ it->second };
+	}
+
+	inline bool IsReady(AssetHandle<Asset> handle) const {
+		return GetEntry(handle).status.load(std::memory_order_acquire) != Loading;
+	}
+
+	inline bool IsFailed(AssetHandle<Asset> handle) const {
+		return GetEntry(handle).status.load(std::memory_order_acquire) == Failed;
 	}
 
-	const Asset& GetAsset(const std::string& assetName) {
-		return *assets[assetName];
+	void Wait(AssetHandle<Asset> handle) const {
+		const Entry& entry = GetEntry(handle);
+		if (entry.status.load(std::memory_order_acquire) == Loading) entry.loading.wait();
 	}
 
-	~AssetManager() {
-		for (auto it = assets.begin(); it != assets.end();) {
-			it = assets.erase(it);
-			
-			if (!assets.empty()) {
-				it++;
-			}
+	// Returns the names of the assets that failed to load
+	std::vector<std::string> WaitAll() const {
+		std::vector<std::string> failed;
+		for (auto& entry : assets) {
+			if (entry->status.load(std::memory_order_acquire) == Loading) entry->loading.wait();
+			if (entry->status.load(std::memory_order_acquire) == Failed) failed.push_back(entry->name);
 		}
+		return failed;
+	}
+
+	bool IsAllReady() const {
+		for (auto& entry : assets) {
+			if (entry->status.load(std::memory_order_acquire) == Loading) return false;
+		}
+		return true;
+	}
+
+	// Blocks only if the asset is still being decoded
+	inline const Asset& GetAsset(AssetHandle<Asset> handle) const {
+		Wait(handle);
+
+		const Entry& entry = GetEntry(handle);
+		if (entry.status.load(std::memory_order_acquire) == Failed) {
+			throw std::runtime_error("Asset " + entry.name + " failed to load");
+		}
+
+		return entry.asset;
+	}
+
+	const Asset& GetAsset(const std::string& assetName) const {
+		return GetAsset(GetHandle(assetName));
 	}
 };
 
 class AssetHolder {
 private:
+	// Fonts keep reading from the mapping, so the archive is destroyed after the managers
+	AssetArchive archive;
+
 	AssetManager<sf::Texture> textureManager;
 	AssetManager<sf::SoundBuffer> soundManager;
 	AssetManager<sf::Font> fontManager;
+
+	// Declared last so that the workers are joined before the assets they write to are destroyed
+	ThreadPool loaderPool;
 	
 	AssetHolder() {}
 public:
@@ -53,19 +166,67 @@ public:
 		return assetMain;
 	}
 
-	bool AddTexture(const std::string& textureName, const std::string& filepath) {
-		return textureManager.LoadAsset(textureName, filepath);
+	// Assets added after mounting are created straight from the mapped archive when it contains their path
+	bool MountArchive(const std::string& filepath) {
+		return archive.Open(filepath);
+	}
+
+	AssetHandle<sf::Texture> AddTexture(const std::string& textureName, const std::string& filepath) {
+		const void* memory = nullptr;
+		std::size_t memorySize = 0;
+		if (archive.IsOpen()) archive.Find(filepath, memory, memorySize);
+
+		return textureManager.LoadAsset(textureName, filepath, &loaderPool, memory, memorySize);
 	}
 	
-	bool AddSoundBuffer(const std::string& soundBufferName, const std::string& filepath) {
-		return soundManager.LoadAsset(soundBufferName, filepath);
+	AssetHandle<sf::SoundBuffer> AddSoundBuffer(const std::string& soundBufferName, const std::string& filepath) {
+		const void* memory = nullptr;
+		std::size_t memorySize = 0;
+		if (archive.IsOpen()) archive.Find(filepath, memory, memorySize);
+
+		return soundManager.LoadAsset(soundBufferName, filepath, &loaderPool, memory, memorySize);
 	}
 	
-	bool AddFont(const std::string& fontName, const std::string& filepath) {
-		return fontManager.LoadAsset(fontName, filepath);
+	AssetHandle<sf::Font> AddFont(const std::string& fontName, const std::string& filepath) {
+		const void* memory = nullptr;
+		std::size_t memorySize = 0;
+		if (archive.IsOpen()) archive.Find(filepath, memory, memorySize);
+
+		return fontManager.LoadAsset(fontName, filepath, &loaderPool, memory, memorySize);
 	}
 
-	const sf::Texture& GetTexture(const std::string& textureName) { return textureManager.GetAsset(textureName); }
-	const sf::SoundBuffer& GetSoundBuffer(const std::string& soundBufferName) { return soundManager.GetAsset(soundBufferName); }
-	const sf::Font& GetFont(const std::string& fontName) { return fontManager.GetAsset(fontName); }
+	AssetHandle<sf::Texture> GetTextureHandle(const std::string& textureName) const { return textureManager.GetHandle(textureName); }
+	AssetHandle<sf::SoundBuffer> GetSoundBufferHandle(const std::string& soundBufferName) const { return soundManager.GetHandle(soundBufferName); }
+	AssetHandle<sf::Font> GetFontHandle(const std::string& fontName) const { return fontManager.GetHandle(fontName); }
+
+	bool IsReady(AssetHandle<sf::Texture> handle) const { return textureManager.IsReady(handle); }
+	bool IsReady(AssetHandle<sf::SoundBuffer> handle) const { return soundManager.IsReady(handle); }
+	bool IsReady(AssetHandle<sf::Font> handle) const { return fontManager.IsReady(handle); }
+
+	bool IsFailed(AssetHandle<sf::Texture> handle) const { return textureManager.IsFailed(handle); }
+	bool IsFailed(AssetHandle<sf::SoundBuffer> handle) const { return soundManager.IsFailed(handle); }
+	bool IsFailed(AssetHandle<sf::Font> handle) const { return fontManager.IsFailed(handle); }
+
+	// For other startup work that should share the loader threads, e.g. ThreadPool::ParallelFor from the main thread
+	ThreadPool& GetLoaderPool() { return loaderPool; }
+
+	bool IsAllReady() const {
+		return textureManager.IsAllReady() && soundManager.IsAllReady() && fontManager.IsAllReady();
+	}
+
+	// Returns the names of every asset that failed to load
+	std::vector<std::string> WaitAll() const {
+		std::vector<std::string> failed = textureManager.WaitAll();
+		for (auto& name : soundManager.WaitAll()) failed.push_back(name);
+		for (auto& name : fontManager.WaitAll()) failed.push_back(name);
+		return failed;
+	}
+
+	const sf::Texture& GetTexture(AssetHandle<sf::Texture> handle) const { return textureManager.GetAsset(handle); }
+	const sf::SoundBuffer& GetSoundBuffer(AssetHandle<sf::SoundBuffer> handle) const { return soundManager.GetAsset(handle); }
+	const sf::Font& GetFont(AssetHandle<sf::Font> handle) const { return fontManager.GetAsset(handle); }
+
+	const sf::Texture& GetTexture(const std::string& textureName) const { return textureManager.GetAsset(textureName); }
+	const sf::SoundBuffer& GetSoundBuffer(const std::string& soundBufferName) const { return soundManager.GetAsset(soundBufferName); }
+	const sf::Font& GetFont(const std::string& fontName) const { return fontManager.GetAsset(fontName); }
 };
\ No newline at end of file
@@ -0,0 +1,422 @@
+#pragma once
+#include "GraphicsRender.h"
+#include <functional>
+#include <unordered_map>
+#include <filesystem>
+
+// A level paged in fixed-size square chunks from a binary level, a text level or a generator.
+// At most chunkCapacity chunks are resident; the least recently used clean chunk is evicted first.
+// Edits are written back to binary levels on eviction; chunks with edits and no writable source stay resident.
+// Binary levels are opened read-only and reopened for writing on the first write-back; Flush then
+// recomputes the checksum and palette, so the file loads through Level::LoadLevel again
+class ChunkedLevel {
+public:
+	using Generator = std::function<void(uint32_t chunkX, uint32_t chunkY, uint32_t chunkSize, char* tiles)>;
+private:
+	enum Source {
+		None = 0,
+		Binary = 1,
+		Text = 2,
+		Generated = 3
+	};
+
+	struct Chunk {
+		uint32_t chunkX, chunkY;
+		std::vector<char> tiles;
+		bool isDirty;
+	};
+
+	std::list<Chunk> chunks;
+	std::unordered_map<uint64_t, std::list<Chunk>::iterator> chunkIndex;
+	Chunk* lastChunk;
+
+	Source source;
+	std::fstream file;
+	std::string filepath;
+	bool isWritable, isReadOnly, isPayloadChanged;
+	uint64_t payloadOffset;
+	std::vector<uint64_t> lineOffsets;
+	std::vector<uint32_t> lineLengths;
+	Generator generator;
+
+	uint32_t width, height;
+	uint32_t chunkShift, chunkSize, chunkMask;
+	std::size_t chunkCapacity;
+	char fillCharacter;
+
+	static inline uint64_t Key(uint32_t chunkX, uint32_t chunkY) {
+		return ((uint64_t)chunkY << 32) | chunkX;
+	}
+
+	void ReadChunk(Chunk& chunk) {
+		std::memset(chunk.tiles.data(), fillCharacter, chunk.tiles.size());
+
+		uint32_t x0 = chunk.chunkX << chunkShift;
+		uint32_t y0 = chunk.chunkY << chunkShift;
+		uint32_t rows = (std::min)(chunkSize, height - y0);
+
+		switch (source) {
+		case Binary: {
+			uint32_t columns = (std::min)(chunkSize, width - x0);
+			for (uint32_t i = 0; i < rows; i++) {
+				file.seekg(payloadOffset + (uint64_t)(y0 + i) * width + x0);
+				file.read(chunk.tiles.data() + (std::size_t)i * chunkSize, columns);
+			}
+			break;
+		}
+		case Text:
+			for (uint32_t i = 0; i < rows; i++) {
+				uint32_t length = lineLengths[y0 + i];
+				if (length <= x0) continue;
+
+				file.seekg(lineOffsets[y0 + i] + x0);
+				file.read(chunk.tiles.data() + (std::size_t)i * chunkSize, (std::min)(chunkSize, length - x0));
+			}
+			break;
+		case Generated:
+			generator(chunk.chunkX, chunk.chunkY, chunkSize, chunk.tiles.data());
+			break;
+		default:
+			break;
+		}
+
+		file.clear();
+	}
+
+	bool MakeWritable() {
+		if (isWritable) return true;
+		if (isReadOnly) return false;
+
+		file.close();
+		file.open(filepath, std::ios::in | std::ios::out | std::ios::binary);
+		if (!file.is_open()) {
+			std::cout << "Couldn't write the level " << filepath << std::endl;
+			file.open(filepath, std::ios::in | std::ios::binary);
+			isReadOnly = true;
+			return false;
+		}
+
+		isWritable = true;
+		return true;
+	}
+
+	// Returns false when the chunk could not be written and has to stay resident
+	bool WriteChunk(const Chunk& chunk) {
+		if (source != Binary || !MakeWritable()) return false;
+
+		uint32_t x0 = chunk.chunkX << chunkShift;
+		uint32_t y0 = chunk.chunkY << chunkShift;
+		uint32_t rows = (std::min)(chunkSize, height - y0);
+		uint32_t columns = (std::min)(chunkSize, width - x0);
+
+		for (uint32_t i = 0; i < rows; i++) {
+			file.seekp(payloadOffset + (uint64_t)(y0 + i) * width + x0);
+			file.write(chunk.tiles.data() + (std::size_t)i * chunkSize, columns);
+		}
+		file.clear();
+
+		isPayloadChanged = true;
+		return true;
+	}
+
+	// Hashes the payload and collects its palette in one pass, then rewrites the header and palette. A palette
+	// that outgrew the space before the payload moves the payload through a rewrite of the whole file
+	bool UpdateHeader() {
+		std::vector<char> buffer(1 << 16); // A multiple of 8, as LevelChecksumUpdate needs
+		uint64_t hash = LevelChecksumSeed, remaining = (uint64_t)width * height;
+		bool isUsed[256] = {};
+
+		file.seekg(payloadOffset);
+		while (remaining > 0) {
+			std::size_t count = (std::size_t)(std::min<uint64_t>)(remaining, buffer.size());
+			if (!file.read(buffer.data(), count)) {
+				file.clear();
+				return false;
+			}
+
+			hash = LevelChecksumUpdate(hash, buffer.data(), count);
+			for (std::size_t i = 0; i < count; i++) isUsed[(uint8_t)buffer[i]] = true;
+			remaining -= count;
+		}
+
+		std::string palette;
+		for (int c = 0; c < 256; c++) {
+			if (isUsed[c]) palette.push_back((char)c);
+		}
+
+		LevelHeader header;
+		std::memcpy(header.magic, LevelMagic, sizeof(LevelMagic));
+		header.version = LevelVersion;
+		header.width = width;
+		header.height = height;
+		header.paletteSize = (uint32_t)palette.size();
+		header.checksum = LevelChecksumFinish(hash);
+		header.payloadOffset = payloadOffset;
+
+		if (sizeof(LevelHeader) + palette.size() > payloadOffset) return RewriteFile(header, palette);
+
+		std::vector<char> padding((std::size_t)payloadOffset - sizeof(LevelHeader) - palette.size(), 0);
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(palette.data(), palette.size());
+		file.write(padding.data(), padding.size());
+		file.flush();
+
+		bool isWritten = file.good();
+		file.clear();
+		return isWritten;
+	}
+
+	bool RewriteFile(LevelHeader& header, const std::string& palette) {
+		header.payloadOffset = (sizeof(LevelHeader) + palette.size() + LevelPayloadAlignment - 1) & ~(LevelPayloadAlignment - 1);
+
+		std::string temporaryPath = filepath + ".tmp";
+		std::ofstream writer(temporaryPath, std::ios::binary);
+		std::vector<char> buffer((std::size_t)header.payloadOffset - sizeof(LevelHeader) - palette.size(), 0);
+		writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		writer.write(palette.data(), palette.size());
+		writer.write(buffer.data(), buffer.size());
+
+		buffer.resize(1 << 16);
+		uint64_t remaining = (uint64_t)width * height;
+		file.seekg(payloadOffset);
+		while (remaining > 0 && writer) {
+			std::size_t count = (std::size_t)(std::min<uint64_t>)(remaining, buffer.size());
+			if (!file.read(buffer.data(), count)) break;
+			writer.write(buffer.data(), count);
+			remaining -= count;
+		}
+		file.clear();
+		writer.close();
+
+		std::error_code error;
+		if (remaining > 0 || !writer) {
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		file.close();
+		std::filesystem::rename(temporaryPath, filepath, error);
+		file.open(filepath, std::ios::in | std::ios::out | std::ios::binary);
+		if (error || !file.is_open()) {
+			std::cout << "Couldn't write the level " << filepath << std::endl;
+			return false;
+		}
+
+		payloadOffset = header.payloadOffset;
+		return true;
+	}
+
+	void Evict() {
+		for (auto it = std::prev(chunks.end());; --it) {
+			if (!it->isDirty || WriteChunk(*it)) {
+				if (lastChunk == &*it) lastChunk = nullptr;
+
+				chunkIndex.erase(Key(it->chunkX, it->chunkY));
+				chunks.erase(it);
+				return;
+			}
+			if (it == chunks.begin()) return;
+		}
+	}
+
+	Chunk& GetChunk(uint32_t chunkX, uint32_t chunkY) {
+		if (lastChunk && lastChunk->chunkX == chunkX && lastChunk->chunkY == chunkY) return *lastChunk;
+
+		auto found = chunkIndex.find(Key(chunkX, chunkY));
+		if (found != chunkIndex.end()) {
+			chunks.splice(chunks.begin(), chunks, found->second);
+		}
+		else {
+			if (chunks.size() >= chunkCapacity) Evict();
+
+			chunks.push_front(Chunk{ chunkX, chunkY, std::vector<char>((std::size_t)chunkSize * chunkSize), false });
+			ReadChunk(chunks.front());
+			chunkIndex[Key(chunkX, chunkY)] = chunks.begin();
+		}
+
+		lastChunk = &chunks.front();
+		return *lastChunk;
+	}
+
+	void Reset(uint32_t w, uint32_t h) {
+		Flush();
+		chunks.clear();
+		chunkIndex.clear();
+		lastChunk = nullptr;
+		lineOffsets.clear();
+		lineLengths.clear();
+		generator = nullptr;
+		if (file.is_open()) file.close();
+		filepath.clear();
+		isWritable = false;
+		isReadOnly = false;
+		isPayloadChanged = false;
+
+		source = None;
+		width = w;
+		height = h;
+	}
+public:
+	// chunkSize is rounded up to a power of two
+	ChunkedLevel(uint32_t chunkSize = 64, std::size_t chunkCapacity = 256, char fillCharacter = '.')
+		: chunkCapacity((std::max<std::size_t>)(chunkCapacity, 1)), fillCharacter(fillCharacter) {
+		chunkShift = 0;
+		while ((1u << chunkShift) < chunkSize) chunkShift++;
+		this->chunkSize = 1u << chunkShift;
+		chunkMask = this->chunkSize - 1;
+
+		lastChunk = nullptr;
+		source = None;
+		isWritable = false;
+		isReadOnly = false;
+		isPayloadChanged = false;
+		payloadOffset = 0;
+		width = height = 0;
+	}
+
+	ChunkedLevel(const ChunkedLevel&) = delete;
+	ChunkedLevel& operator=(const ChunkedLevel&) = delete;
+
+	// Binary levels are paged straight from the payload and edited in place on eviction. The header gets
+	// the same checks as in Level::LoadLevel, so a corrupt one never seeks past the end of the file
+	bool OpenBinary(const std::string& filepath) {
+		Reset(0, 0);
+
+		file.open(filepath, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file.is_open()) return false;
+
+		uint64_t fileSize = (uint64_t)file.tellg();
+		file.seekg(0);
+
+		LevelHeader header;
+		bool isValid = fileSize >= sizeof(LevelHeader) && file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+			std::memcmp(header.magic, LevelMagic, sizeof(LevelMagic)) == 0 && header.version == LevelVersion;
+
+		uint64_t payloadSize = isValid ? (uint64_t)header.width * header.height : 0;
+		if (!isValid || header.payloadOffset < sizeof(LevelHeader) + (uint64_t)header.paletteSize ||
+			header.payloadOffset > fileSize || payloadSize > fileSize - header.payloadOffset) {
+			std::cout << "Couldn't load the level " << filepath << std::endl;
+			file.close();
+			return false;
+		}
+
+		this->filepath = filepath;
+		source = Binary;
+		payloadOffset = header.payloadOffset;
+		width = header.width;
+		height = header.height;
+		return true;
+	}
+
+	// Text levels are indexed once by line; only the offsets stay resident
+	bool OpenText(const std::string& filepath) {
+		Reset(0, 0);
+
+		file.open(filepath, std::ios::in | std::ios::binary);
+		if (!file.is_open()) return false;
+
+		std::vector<char> buffer(1 << 16);
+		uint64_t offset = 0, lineStart = 0;
+		uint32_t levelWidth = 0;
+
+		auto addLine = [&](uint64_t lineEnd, bool isCarriageReturn) {
+			uint64_t length = lineEnd - lineStart - (isCarriageReturn ? 1 : 0);
+			if (length > 0) {
+				lineOffsets.push_back(lineStart);
+				lineLengths.push_back((uint32_t)length);
+				if (lineOffsets.size() == 1) levelWidth = (uint32_t)length;
+			}
+		};
+
+		char previous = '\0';
+		while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+			std::size_t count = (std::size_t)file.gcount();
+			for (std::size_t i = 0; i < count; i++) {
+				if (buffer[i] == '\n') {
+					addLine(offset + i, previous == '\r');
+					lineStart = offset + i + 1;
+				}
+				previous = buffer[i];
+			}
+			offset += count;
+		}
+		addLine(offset, previous == '\r');
+
+		file.clear();
+		source = Text;
+		width = levelWidth;
+		height = (uint32_t)lineOffsets.size();
+		return true;
+	}
+
+	// The generator fills a chunkSize * chunkSize tile block for a chunk coordinate on every page-in
+	void OpenGenerator(uint32_t w, uint32_t h, Generator chunkGenerator) {
+		Reset(w, h);
+
+		source = Generated;
+		generator = std::move(chunkGenerator);
+	}
+
+	// Pages in every chunk overlapping the region plus margin tiles, most recently used first
+	void SetViewport(int x, int y, int w, int h, int margin = 0) {
+		int x0 = (std::max)(x - margin, 0), y0 = (std::max)(y - margin, 0);
+		int x1 = (std::min)(x + w + margin, (int)width) - 1, y1 = (std::min)(y + h + margin, (int)height) - 1;
+		if (x1 < x0 || y1 < y0) return;
+
+		for (uint32_t chunkY = (uint32_t)y0 >> chunkShift; chunkY <= ((uint32_t)y1 >> chunkShift); chunkY++) {
+			for (uint32_t chunkX = (uint32_t)x0 >> chunkShift; chunkX <= ((uint32_t)x1 >> chunkShift); chunkX++) {
+				GetChunk(chunkX, chunkY);
+			}
+		}
+	}
+
+	// Tiles outside the level read as the fill character
+	char At(int x, int y) {
+		if ((uint32_t)x >= width || (uint32_t)y >= height) return fillCharacter;
+
+		Chunk& chunk = GetChunk((uint32_t)x >> chunkShift, (uint32_t)y >> chunkShift);
+		return chunk.tiles[(((uint32_t)y & chunkMask) << chunkShift) | ((uint32_t)x & chunkMask)];
+	}
+
+	bool SetTile(int x, int y, char c) {
+		if ((uint32_t)x >= width || (uint32_t)y >= height) return false;
+
+		Chunk& chunk = GetChunk((uint32_t)x >> chunkShift, (uint32_t)y >> chunkShift);
+		chunk.tiles[(((uint32_t)y & chunkMask) << chunkShift) | ((uint32_t)x & chunkMask)] = c;
+		chunk.isDirty = true;
+		return true;
+	}
+
+	// Writes every edited chunk back to a binary level and brings its header up to date. Returns false when
+	// an edit or the header could not be written
+	bool Flush() {
+		if (source != Binary) return true;
+
+		bool isWritten = true;
+		for (auto& chunk : chunks) {
+			if (!chunk.isDirty) continue;
+
+			if (WriteChunk(chunk)) chunk.isDirty = false;
+			else isWritten = false;
+		}
+
+		if (isPayloadChanged) {
+			file.flush();
+			if (UpdateHeader()) isPayloadChanged = false;
+			else isWritten = false;
+		}
+
+		return isWritten;
+	}
+
+	inline uint32_t GetWidth() const { return width; }
+	inline uint32_t GetHeight() const { return height; }
+	inline uint32_t GetChunkSize() const { return chunkSize; }
+	inline std::size_t GetResidentChunkCount() const { return chunks.size(); }
+	inline std::size_t GetChunkCapacity() const { return chunkCapacity; }
+
+	~ChunkedLevel() {
+		Flush();
+	}
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+// Sequence with a gap kept at the cursor. Inserting and erasing at the cursor is amortized O(1) and moving
+// the cursor costs the distance moved, so typing into a long text never copies the whole of it. Per-character
+// data that has to follow the text (glyph quads, positions) is kept in more buffers with the same cursor
+template<typename T = char>
+class GapBuffer {
+private:
+	std::vector<T> data;
+	std::size_t gapStart, gapEnd; // The gap is data[gapStart, gapEnd); gapStart is the cursor
+
+	void Grow(std::size_t required) {
+		std::size_t tail = data.size() - gapEnd;
+		std::size_t newCapacity = (std::max)(data.size() * 2, GetSize() + required + 16);
+
+		data.resize(newCapacity);
+		std::copy_backward(data.begin() + gapEnd, data.begin() + gapEnd + tail, data.end());
+		gapEnd = newCapacity - tail;
+	}
+public:
+	GapBuffer(std::size_t capacity = 64)
+		: data(capacity) {
+		gapStart = 0;
+		gapEnd = capacity;
+	}
+
+	inline std::size_t GetSize() const { return data.size() - (gapEnd - gapStart); }
+	inline std::size_t GetCursor() const { return gapStart; }
+
+	inline const T& operator[](std::size_t i) const {
+		return i < gapStart ? data[i] : data[i + (gapEnd - gapStart)];
+	}
+
+	inline T& operator[](std::size_t i) {
+		return i < gapStart ? data[i] : data[i + (gapEnd - gapStart)];
+	}
+
+	// The elements before and after the gap, each contiguous
+	inline const T* GetFront() const { return data.data(); }
+	inline std::size_t GetFrontSize() const { return gapStart; }
+	inline const T* GetBack() const { return data.data() + gapEnd; }
+	inline std::size_t GetBackSize() const { return data.size() - gapEnd; }
+
+	void MoveCursor(std::size_t position) {
+		position = (std::min)(position, GetSize());
+
+		if (position < gapStart) {
+			std::size_t n = gapStart - position;
+			std::copy_backward(data.begin() + position, data.begin() + gapStart, data.begin() + gapEnd);
+			gapStart -= n;
+			gapEnd -= n;
+		}
+		else if (position > gapStart) {
+			std::size_t n = position - gapStart;
+			std::copy(data.begin() + gapEnd, data.begin() + gapEnd + n, data.begin() + gapStart);
+			gapStart += n;
+			gapEnd += n;
+		}
+	}
+
+	void Insert(const T* items, std::size_t n) {
+		if (gapEnd - gapStart < n) Grow(n);
+
+		std::copy(items, items + n, data.begin() + gapStart);
+		gapStart += n;
+	}
+
+	void Insert(const T& item) {
+		Insert(&item, 1);
+	}
+
+	// Removes the character before the cursor, like backspace
+	bool Erase() {
+		if (gapStart == 0) return false;
+
+		gapStart--;
+		return true;
+	}
+
+	// Removes the character after the cursor, like delete
+	bool Delete() {
+		if (gapEnd == data.size()) return false;
+
+		gapEnd++;
+		return true;
+	}
+
+	void Clear() {
+		gapStart = 0;
+		gapEnd = data.size();
+	}
+
+	// For text: first index of the line holding position, and the index of the '\n' ending it (or the size)
+	std::size_t GetLineStart(std::size_t position) const {
+		while (position > 0 && (*this)[position - 1] != '\n') position--;
+		return position;
+	}
+
+	std::size_t GetLineEnd(std::size_t position) const {
+		std::size_t size = GetSize();
+		while (position < size && (*this)[position] != '\n') position++;
+		return position;
+	}
+
+	std::string ToString() const {
+		std::string str;
+		str.reserve(GetSize());
+		str.append(data.data(), gapStart);
+		str.append(data.data() + gapEnd, data.size() - gapEnd);
+		return str;
+	}
+};
@@ -1,13 +1,27 @@
 #pragma once
 
-#include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/VertexBuffer.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Graphics/Text.hpp>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <vector>
+#include <list>
+#include <cmath>
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <string_view>
+#include <memory>
+#include <array>
+#include <unordered_map>
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "RenderSurface.h"
 
 struct Tile {
 	int x, y;
@@ -17,17 +31,348 @@ struct Tile {
 		: x(x), y(y), tileCharacter(c) {}
 };
 
+// Row-major tile storage: one contiguous buffer, row y starts at y * width.
+// The buffer is either owned or a copy-on-write view into a mapped level file
+class TileGrid {
+private:
+	std::vector<char> storage;
+	std::shared_ptr<MappedFile> mapping;
+	char* tiles;
+	uint32_t width, height;
+
+	// Unsigned compares fold the negative and upper bound checks into one test per axis
+	template<typename GetX, typename GetY, typename GetChar>
+	void PlaceTilesImpl(std::size_t count, GetX getX, GetY getY, GetChar getChar) {
+		for (std::size_t i = 0; i < count; i++) {
+			uint32_t x = (uint32_t)getX(i), y = (uint32_t)getY(i);
+			if ((x < width) & (y < height)) tiles[(std::size_t)y * width + x] = getChar(i);
+		}
+	}
+
+	void CopyFrom(const TileGrid& other) {
+		width = other.width;
+		height = other.height;
+		storage.assign(other.tiles, other.tiles + other.GetSize());
+		mapping.reset();
+		tiles = storage.data();
+	}
+public:
+	TileGrid() {
+		tiles = nullptr;
+		width = height = 0;
+	}
+
+	TileGrid(uint32_t w, uint32_t h, char fill = '.') {
+		Resize(w, h, fill);
+	}
+
+	// Copies never share a mapping, so writes to one grid are not seen by the other
+	TileGrid(const TileGrid& other) {
+		CopyFrom(other);
+	}
+
+	TileGrid& operator=(const TileGrid& other) {
+		if (this != &other) CopyFrom(other);
+		return *this;
+	}
+
+	TileGrid(TileGrid&& other) noexcept
+		: storage(std::move(other.storage)), mapping(std::move(other.mapping)), tiles(other.tiles), width(other.width), height(other.height) {
+		other.tiles = nullptr;
+		other.width = other.height = 0;
+	}
+
+	TileGrid& operator=(TileGrid&& other) noexcept {
+		storage = std::move(other.storage);
+		mapping = std::move(other.mapping);
+		tiles = other.tiles;
+		width = other.width;
+		height = other.height;
+
+		other.tiles = nullptr;
+		other.width = other.height = 0;
+		return *this;
+	}
+
+	void Resize(uint32_t w, uint32_t h, char fill = '.') {
+		width = w;
+		height = h;
+		mapping.reset();
+		storage.assign((std::size_t)w * h, fill);
+		tiles = storage.data();
+	}
+
+	// Uses w * h bytes at offset inside a copy-on-write mapping as the tile buffer without copying
+	void Adopt(std::shared_ptr<MappedFile> file, std::size_t offset, uint32_t w, uint32_t h) {
+		storage.clear();
+		storage.shrink_to_fit();
+		mapping = std::move(file);
+		tiles = reinterpret_cast<char*>(mapping->GetMutableData() + offset);
+		width = w;
+		height = h;
+	}
+
+	// Takes w * h row-major bytes as the tile buffer
+	void Assign(std::vector<char>&& buffer, uint32_t w, uint32_t h) {
+		width = w;
+		height = h;
+		mapping.reset();
+		storage = std::move(buffer);
+		storage.resize((std::size_t)w * h, '.');
+		tiles = storage.data();
+	}
+
+	inline bool IsMapped() const { return mapping != nullptr; }
+
+	void Fill(char c) {
+		if (GetSize() > 0) std::memset(tiles, c, GetSize());
+	}
+
+	// Copies up to width characters into row y and pads the rest of the row with fill
+	void SetRow(uint32_t y, const char* row, std::size_t length, char fill = '.') {
+		char* dst = GetRowData(y);
+		std::size_t n = (std::min<std::size_t>)(length, width);
+
+		std::memcpy(dst, row, n);
+		if (n < width) std::memset(dst + n, fill, width - n);
+	}
+
+	inline bool IsInBounds(int x, int y) const {
+		return (uint32_t)x < width && (uint32_t)y < height;
+	}
+
+	// Bulk placement; out-of-bounds tiles are dropped and later placements win over earlier ones
+	void PlaceTiles(const int* xs, const int* ys, const char* chars, std::size_t count) {
+		PlaceTilesImpl(count, [xs](std::size_t i) { return xs[i]; }, [ys](std::size_t i) { return ys[i]; }, [chars](std::size_t i) { return chars[i]; });
+	}
+
+	void PlaceTiles(const Tile* placements, std::size_t count) {
+		PlaceTilesImpl(count, [placements](std::size_t i) { return placements[i].x; }, [placements](std::size_t i) { return placements[i].y; }, [placements](std::size_t i) { return placements[i].tileCharacter; });
+	}
+
+	inline char& At(uint32_t x, uint32_t y) { return tiles[(std::size_t)y * width + x]; }
+	inline char At(uint32_t x, uint32_t y) const { return tiles[(std::size_t)y * width + x]; }
+
+	inline char* GetRowData(uint32_t y) { return tiles + (std::size_t)y * width; }
+	inline const char* GetRowData(uint32_t y) const { return tiles + (std::size_t)y * width; }
+	inline std::string_view GetRow(uint32_t y) const { return std::string_view(GetRowData(y), width); }
+
+	inline char* GetData() { return tiles; }
+	inline const char* GetData() const { return tiles; }
+	inline std::size_t GetSize() const { return (std::size_t)width * height; }
+
+	inline uint32_t GetWidth() const { return width; }
+	inline uint32_t GetHeight() const { return height; }
+	inline uint32_t GetStride() const { return width; }
+};
+
+// Hash grid for mostly-empty maps: only 16x16 blocks that hold a placed tile are allocated,
+// every other tile reads as the fill character
+class SparseTileGrid {
+private:
+	static constexpr uint32_t BlockShift = 4;
+	static constexpr uint32_t BlockSize = 1u << BlockShift;
+	static constexpr uint32_t BlockMask = BlockSize - 1;
+
+	using Block = std::array<char, BlockSize * BlockSize>;
+
+	std::unordered_map<uint64_t, Block> blocks;
+	uint32_t width, height;
+	char fillCharacter;
+
+	static inline uint64_t Key(uint32_t x, uint32_t y) {
+		return ((uint64_t)(y >> BlockShift) << 32) | (x >> BlockShift);
+	}
+
+	static inline uint32_t Offset(uint32_t x, uint32_t y) {
+		return ((y & BlockMask) << BlockShift) | (x & BlockMask);
+	}
+
+	Block& GetBlock(uint32_t x, uint32_t y) {
+		auto [it, isInserted] = blocks.try_emplace(Key(x, y));
+		if (isInserted) it->second.fill(fillCharacter);
+		return it->second;
+	}
+public:
+	SparseTileGrid(uint32_t w = 0, uint32_t h = 0, char fill = '.')
+		: width(w), height(h), fillCharacter(fill) {}
+
+	inline bool IsInBounds(int x, int y) const {
+		return (uint32_t)x < width && (uint32_t)y < height;
+	}
+
+	char At(uint32_t x, uint32_t y) const {
+		auto it = blocks.find(Key(x, y));
+		return it == blocks.end() ? fillCharacter : it->second[Offset(x, y)];
+	}
+
+	void SetTile(uint32_t x, uint32_t y, char c) {
+		GetBlock(x, y)[Offset(x, y)] = c;
+	}
+
+	void PlaceTiles(const int* xs, const int* ys, const char* chars, std::size_t count) {
+		for (std::size_t i = 0; i < count; i++) {
+			if (IsInBounds(xs[i], ys[i])) SetTile(xs[i], ys[i], chars[i]);
+		}
+	}
+
+	void PlaceTiles(const Tile* placements, std::size_t count) {
+		for (std::size_t i = 0; i < count; i++) {
+			if (IsInBounds(placements[i].x, placements[i].y)) SetTile(placements[i].x, placements[i].y, placements[i].tileCharacter);
+		}
+	}
+
+	// Expands into a dense grid, copying each allocated block row by row
+	TileGrid ToTileGrid() const {
+		TileGrid grid(width, height, fillCharacter);
+
+		for (auto& [key, block] : blocks) {
+			uint32_t x0 = (uint32_t)key << BlockShift;
+			uint32_t y0 = (uint32_t)(key >> 32) << BlockShift;
+			uint32_t columns = (std::min)(BlockSize, width - x0);
+
+			for (uint32_t i = 0; i < BlockSize && y0 + i < height; i++) {
+				std::memcpy(grid.GetRowData(y0 + i) + x0, block.data() + i * BlockSize, columns);
+			}
+		}
+
+		return grid;
+	}
+
+	inline std::size_t GetBlockCount() const { return blocks.size(); }
+	inline uint32_t GetWidth() const { return width; }
+	inline uint32_t GetHeight() const { return height; }
+};
+
+// Binary level layout: LevelHeader, paletteSize palette characters, then the
+// width * height row-major tile payload at payloadOffset
+struct LevelHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t width, height;
+	uint32_t paletteSize;
+	uint32_t checksum;
+	uint64_t payloadOffset;
+};
+
+constexpr char LevelMagic[4] = { 'T', 'C', 'L', 'V' };
+constexpr uint32_t LevelVersion = 1;
+constexpr uint64_t LevelPayloadAlignment = 64;
+
+// Level files can come from anywhere, so every build checks the payload checksum on load unless it
+// defines LEVEL_VERIFY_CHECKSUM as 0
+#ifndef LEVEL_VERIFY_CHECKSUM
+#define LEVEL_VERIFY_CHECKSUM 1
+#endif
+
+constexpr uint64_t LevelChecksumSeed = 14695981039346656037ull;
+
+// FNV-1a over 8-byte words with a byte-wise tail. A payload can be hashed in pieces by passing the
+// previous result back in, as long as every piece but the last is a multiple of 8 bytes
+inline uint64_t LevelChecksumUpdate(uint64_t hash, const char* data, std::size_t size) {
+	std::size_t i = 0;
+
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+
+	for (; i < size; i++) {
+		hash = (hash ^ (uint8_t)data[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+inline uint32_t LevelChecksumFinish(uint64_t hash) {
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+inline uint32_t LevelChecksum(const char* data, std::size_t size) {
+	return LevelChecksumFinish(LevelChecksumUpdate(LevelChecksumSeed, data, size));
+}
+
 class Level {
 private:
-	std::vector<std::string> levelVector;
+	TileGrid grid;
+	std::string palette;
 	uint32_t width, height;
+
+	// Streams the rows straight into the tile buffer, so only the grid and one line are held in memory
+	static Level LoadLevelText(std::istream& reader, uint64_t fileSize) {
+		std::vector<char> tiles;
+		std::string line;
+		uint32_t levelWidth = 0, levelHeight = 0;
+
+		while (std::getline(reader, line)) {
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (line.empty()) continue;
+
+			if (levelHeight == 0) {
+				levelWidth = (uint32_t)line.size();
+				// Exact when every row has the width of the first one
+				tiles.reserve((std::size_t)(fileSize / (line.size() + 1)) * levelWidth);
+			}
+
+			std::size_t n = (std::min<std::size_t>)(line.size(), levelWidth);
+			tiles.insert(tiles.end(), line.data(), line.data() + n);
+			tiles.resize(tiles.size() + levelWidth - n, '.');
+			levelHeight++;
+		}
+
+		Level level;
+		level.width = levelWidth;
+		level.height = levelHeight;
+		level.grid.Assign(std::move(tiles), levelWidth, levelHeight);
+
+		return level;
+	}
+
+	static Level LoadLevelBinary(std::shared_ptr<MappedFile> file, const std::string& filepath, bool verifyChecksum) {
+		LevelHeader header;
+		std::memcpy(&header, file->GetData(), sizeof(header));
+
+		// Every size is checked in 64 bits before anything past the header is touched
+		uint64_t fileSize = file->GetSize();
+		uint64_t payloadSize = (uint64_t)header.width * header.height;
+		if (header.version != LevelVersion || header.payloadOffset < sizeof(LevelHeader) + (uint64_t)header.paletteSize ||
+			header.payloadOffset > fileSize || payloadSize > fileSize - header.payloadOffset) {
+			std::cout << "Couldn't load the level " << filepath << std::endl;
+			return Level();
+		}
+
+		const char* payload = reinterpret_cast<const char*>(file->GetData() + header.payloadOffset);
+		if (verifyChecksum && LevelChecksum(payload, (std::size_t)payloadSize) != header.checksum) {
+			std::cout << "Checksum mismatch in the level " << filepath << std::endl;
+			return Level();
+		}
+
+		Level level;
+		level.width = header.width;
+		level.height = header.height;
+		level.palette.assign(reinterpret_cast<const char*>(file->GetData() + sizeof(LevelHeader)), header.paletteSize);
+		level.grid.Adopt(std::move(file), (std::size_t)header.payloadOffset, header.width, header.height);
+
+		return level;
+	}
 public:
 	Level() {
 		width = height = 0;
 	}
 
 	Level(const std::vector<std::string>& level, uint32_t w, uint32_t h)
-		: levelVector(level), width(w), height(h) {}
+		: grid(w, h), width(w), height(h) {
+		for (uint32_t i = 0; i < h && i < (uint32_t)level.size(); i++) {
+			grid.SetRow(i, level[i].data(), level[i].size());
+		}
+	}
+
+	explicit Level(TileGrid tiles)
+		: grid(std::move(tiles)) {
+		width = grid.GetWidth();
+		height = grid.GetHeight();
+	}
 
 	void SetSize(uint32_t w, uint32_t h) {
 		width = w;
@@ -35,13 +380,7 @@ public:
 	}
 
 	void InitializeLevelString() {
-		for (int i = 0; i < (int)height; i++) {
-			std::string line;
-			for (int j = 0; j < (int)width; j++) {
-				line.push_back('.');
-			}
-			levelVector.push_back(line);
-		}
+		grid.Resize(width, height, '.');
 	}
 
 	void InitializeLevelString(uint32_t w, uint32_t h) {
@@ -49,134 +388,559 @@ public:
 		width = w;
 		height = h;
 
-		for (int i = 0; i < (int)h; i++) {
-			std::string line;
-			for (int j = 0; j < (int)w; j++) {
-				line.push_back('.');
-			}
-			levelVector.push_back(line);
-		}
+		grid.Resize(w, h, '.');
 	}
 
-	static Level LoadLevel(const std::string& filepath) {
-		std::ifstream reader(filepath);
-		
-		Level level;
-
-		if (reader.is_open()) {
+	// Binary levels are detected by their magic and used in place from a copy-on-write mapping;
+	// anything else is read as text, one row per non-empty line
+	static Level LoadLevel(const std::string& filepath, bool verifyChecksum = LEVEL_VERIFY_CHECKSUM) {
+		std::ifstream reader(filepath, std::ios::binary | std::ios::ate);
+		if (!reader.is_open()) {
+			std::cout << "Couldn't load the level " << filepath << std::endl;
+			return Level();
+		}
 
-			while (!reader.eof()) {
-				std::string line;
-				reader >> line;
-				level.levelVector.push_back(line);
-			}
+		uint64_t fileSize = (uint64_t)reader.tellg();
+		reader.seekg(0);
 
+		char magic[sizeof(LevelMagic)] = {};
+		if (fileSize >= sizeof(LevelHeader) && reader.read(magic, sizeof(magic)) && std::memcmp(magic, LevelMagic, sizeof(LevelMagic)) == 0) {
 			reader.close();
-		}
 
-		level.width = level.levelVector[0].size();
-		level.height = level.levelVector.size();
+			std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+			if (!file->Open(filepath, true)) return Level();
+			return LoadLevelBinary(std::move(file), filepath, verifyChecksum);
+		}
 
-		return level;
+		reader.clear();
+		reader.seekg(0);
+		return LoadLevelText(reader, fileSize);
 	}
 	
+	// Writes to files/levels/<filename>
 	void SaveLevel(const std::string& filename) {
 		std::ofstream writer("files/levels/" + filename);
 
 		if (writer.is_open()) {
 			for (uint32_t i = 0; i < height; i++) {
-				writer << levelVector[i] << "\n";
+				writer << grid.GetRow(i) << "\n";
 			}
 			writer.close();
 		}
 	}
 
+	bool SaveLevelBinary(const std::string& filepath) {
+		std::ofstream writer(filepath, std::ios::binary);
+		if (!writer.is_open()) return false;
+
+		ComputePalette();
+
+		LevelHeader header;
+		std::memcpy(header.magic, LevelMagic, sizeof(LevelMagic));
+		header.version = LevelVersion;
+		header.width = width;
+		header.height = height;
+		header.paletteSize = (uint32_t)palette.size();
+		header.checksum = LevelChecksum(grid.GetData(), grid.GetSize());
+		header.payloadOffset = (sizeof(LevelHeader) + palette.size() + LevelPayloadAlignment - 1) & ~(LevelPayloadAlignment - 1);
+
+		const char padding[LevelPayloadAlignment] = {};
+		writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		writer.write(palette.data(), palette.size());
+		writer.write(padding, header.payloadOffset - sizeof(header) - palette.size());
+		writer.write(grid.GetData(), grid.GetSize());
+
+		return writer.good();
+	}
+
 	static Level LoadLevel(const std::list<Tile>& positions, uint32_t levelWidth, uint32_t levelHeight) {
 		Level level;
-		level.SetSize(levelWidth, levelHeight);
-		level.InitializeLevelString();
+		level.InitializeLevelString(levelWidth, levelHeight);
 
 		for (auto& pos : positions) {
-			if (pos.x < 0 || pos.x > (int)(levelWidth - 1) || pos.y < 0 || pos.y > (int)(levelHeight - 1)) continue;
-			level.levelVector[pos.y][pos.x] = pos.tileCharacter;
+			if (!level.grid.IsInBounds(pos.x, pos.y)) continue;
+			level.grid.At(pos.x, pos.y) = pos.tileCharacter;
 		}
 
 		return level;
 	}
 
+	static Level LoadLevel(const Tile* placements, std::size_t count, uint32_t levelWidth, uint32_t levelHeight) {
+		Level level;
+		level.InitializeLevelString(levelWidth, levelHeight);
+		level.grid.PlaceTiles(placements, count);
+
+		return level;
+	}
+
+	static Level LoadLevel(const std::vector<Tile>& placements, uint32_t levelWidth, uint32_t levelHeight) {
+		return LoadLevel(placements.data(), placements.size(), levelWidth, levelHeight);
+	}
+
+	// Structure-of-arrays placements: xs[i], ys[i] and chars[i] describe one tile
+	static Level LoadLevel(const int* xs, const int* ys, const char* chars, std::size_t count, uint32_t levelWidth, uint32_t levelHeight) {
+		Level level;
+		level.InitializeLevelString(levelWidth, levelHeight);
+		level.grid.PlaceTiles(xs, ys, chars, count);
+
+		return level;
+	}
+
+	// Distinct tile characters in ascending order
+	const std::string& ComputePalette() {
+		bool isUsed[256] = {};
+		const char* tiles = grid.GetData();
+		for (std::size_t i = 0; i < grid.GetSize(); i++) {
+			isUsed[(uint8_t)tiles[i]] = true;
+		}
+
+		palette.clear();
+		for (int c = 0; c < 256; c++) {
+			if (isUsed[c]) palette.push_back((char)c);
+		}
+
+		return palette;
+	}
+
 	void PrintLevel() {
 		system("cls");
-		for (std::size_t i = 0; i < height; i++) {
-			std::cout << levelVector[i] << std::endl;
+		for (uint32_t i = 0; i < height; i++) {
+			std::cout << grid.GetRow(i) << '\n';
 		}
+		std::cout.flush();
 	}
 
 	inline uint32_t GetWidth() const { return width; }
 	inline uint32_t GetHeight() const { return height; }
 
-	std::vector<std::string> GetLevel() const { return levelVector; }
+	inline char At(uint32_t x, uint32_t y) const { return grid.At(x, y); }
+	inline void SetTile(uint32_t x, uint32_t y, char c) { grid.At(x, y) = c; }
+
+	inline std::string_view GetRow(uint32_t y) const { return grid.GetRow(y); }
+	inline const TileGrid& GetGrid() const { return grid; }
+	inline TileGrid& GetGrid() { return grid; }
+
+	// Palette stored in a binary level, or the last ComputePalette result
+	inline const std::string& GetPalette() const { return palette; }
 };
 
-void DrawLine(sf::RenderWindow& window, float x1, float y1, float x2, float y2, sf::Color color = sf::Color::White) {
-	sf::VertexArray line(sf::LineStrip, 2);
+// Draws a Level as one quad per tile mapped through a tile atlas. The vertices are built once and only
+// the 16-row bands marked dirty are rebuilt, so an unchanged level is a single draw call per frame
+class LevelRenderer {
+private:
+	static constexpr uint32_t RowsPerBand = 16;
+
+	const Level* level;
+	const sf::Texture* atlas;
+	uint32_t atlasTileSize, atlasColumns;
+	sf::Vector2f position;
+	float tileSize;
+
+	int32_t atlasIndices[256];
+	sf::Color tileColors[256];
+
+	std::vector<sf::Vertex> vertices;
+	sf::VertexBuffer buffer;
+	bool isBufferUsed;
+	std::vector<uint8_t> dirtyBands;
+	bool isAnyDirty;
+
+	void BuildBand(uint32_t band) {
+		uint32_t width = level->GetWidth();
+		uint32_t y1 = (std::min)((band + 1) * RowsPerBand, level->GetHeight());
+
+		for (uint32_t y = band * RowsPerBand; y < y1; y++) {
+			const char* row = level->GetGrid().GetRowData(y);
+			sf::Vertex* quad = &vertices[(std::size_t)y * width * 4];
+
+			for (uint32_t x = 0; x < width; x++, quad += 4) {
+				uint8_t c = (uint8_t)row[x];
+				int32_t index = atlasIndices[c];
+
+				if (index < 0) {
+					quad[0].position = quad[1].position = quad[2].position = quad[3].position = sf::Vector2f();
+					continue;
+				}
+
+				float left = position.x + x * tileSize, top = position.y + y * tileSize;
+				quad[0].position = { left, top };
+				quad[1].position = { left + tileSize, top };
+				quad[2].position = { left + tileSize, top + tileSize };
+				quad[3].position = { left, top + tileSize };
+
+				quad[0].color = quad[1].color = quad[2].color = quad[3].color = tileColors[c];
+
+				if (atlas) {
+					float u = (float)((index % atlasColumns) * atlasTileSize), v = (float)((index / atlasColumns) * atlasTileSize);
+					quad[0].texCoords = { u, v };
+					quad[1].texCoords = { u + atlasTileSize, v };
+					quad[2].texCoords = { u + atlasTileSize, v + atlasTileSize };
+					quad[3].texCoords = { u, v + atlasTileSize };
+				}
+			}
+		}
+
+		if (isBufferUsed) {
+			std::size_t first = (std::size_t)band * RowsPerBand * width * 4;
+			std::size_t count = (std::size_t)(y1 - band * RowsPerBand) * width * 4;
+			buffer.update(&vertices[first], count, (unsigned)first);
+		}
+	}
+public:
+	LevelRenderer() {
+		level = nullptr;
+		atlas = nullptr;
+		atlasTileSize = atlasColumns = 0;
+		tileSize = 0.0f;
+		isBufferUsed = false;
+		isAnyDirty = false;
+
+		for (int i = 0; i < 256; i++) {
+			atlasIndices[i] = -1;
+			tileColors[i] = sf::Color::White;
+		}
+	}
+
+	// The level must outlive the renderer; changing its size requires another SetLevel
+	void SetLevel(const Level& newLevel, float newTileSize, const sf::Vector2f& newPosition = { 0.0f, 0.0f }) {
+		level = &newLevel;
+		tileSize = newTileSize;
+		position = newPosition;
 
-	line[0].position = { x1, y1 };
-	line[0].color = color;
-	line[1].position = { x2, y2 };
-	line[1].color = color;
+		vertices.assign((std::size_t)level->GetWidth() * level->GetHeight() * 4, sf::Vertex());
 
-	window.draw(line);
-}
+		isBufferUsed = sf::VertexBuffer::isAvailable();
+		if (isBufferUsed) {
+			buffer.setPrimitiveType(sf::Quads);
+			buffer.setUsage(sf::VertexBuffer::Static);
+			isBufferUsed = buffer.create(vertices.size());
+		}
+
+		dirtyBands.assign((level->GetHeight() + RowsPerBand - 1) / RowsPerBand, 0);
+		MarkAllDirty();
+	}
+
+	// Atlas tiles are square, laid out left to right and top to bottom
+	void SetAtlas(const sf::Texture& texture, uint32_t newAtlasTileSize) {
+		atlas = &texture;
+		atlasTileSize = newAtlasTileSize;
+		atlasColumns = (std::max)(1u, texture.getSize().x / newAtlasTileSize);
+		MarkAllDirty();
+	}
+
+	// Characters that are never mapped are not drawn
+	void MapTile(char c, uint32_t atlasIndex, sf::Color color = sf::Color::White) {
+		atlasIndices[(uint8_t)c] = (int32_t)atlasIndex;
+		tileColors[(uint8_t)c] = color;
+		MarkAllDirty();
+	}
+
+	void MarkRowDirty(uint32_t y) {
+		if (y / RowsPerBand < dirtyBands.size()) {
+			dirtyBands[y / RowsPerBand] = 1;
+			isAnyDirty = true;
+		}
+	}
+
+	void MarkRowsDirty(uint32_t y0, uint32_t y1) {
+		for (uint32_t band = y0 / RowsPerBand; band <= y1 / RowsPerBand && band < dirtyBands.size(); band++) {
+			dirtyBands[band] = 1;
+			isAnyDirty = true;
+		}
+	}
+
+	void MarkAllDirty() {
+		std::fill(dirtyBands.begin(), dirtyBands.end(), 1);
+		isAnyDirty = !dirtyBands.empty();
+	}
+
+	void SetTile(Level& target, uint32_t x, uint32_t y, char c) {
+		if (target.At(x, y) == c) return;
+
+		target.SetTile(x, y, c);
+		if (&target == level) MarkRowDirty(y);
+	}
+
+	void Update() {
+		if (!isAnyDirty || !level) return;
+
+		for (uint32_t band = 0; band < (uint32_t)dirtyBands.size(); band++) {
+			if (dirtyBands[band]) {
+				BuildBand(band);
+				dirtyBands[band] = 0;
+			}
+		}
+		isAnyDirty = false;
+	}
+
+	// A CPU surface has no access to the vertex buffer and draws the vertices kept for it instead
+	void Render(RenderSurface& surface) {
+		Update();
+		if (vertices.empty()) return;
+
+		sf::RenderStates states;
+		states.texture = atlas;
+
+		if (isBufferUsed && surface.GetTarget()) surface.GetTarget()->draw(buffer, states);
+		else surface.Draw(vertices.data(), vertices.size(), sf::Quads, states);
+	}
+
+	inline std::size_t GetVertexCount() const { return vertices.size(); }
+};
+
+// Collects primitives and draws them in the order they were added, one draw call per run of the same
+// primitive type. Anything drawn without the batch (text, sprites, shapes) must come after a Flush, or it
+// ends up under primitives that were added before it
+class PrimitiveBatch {
+private:
+	struct Run {
+		sf::PrimitiveType type;
+		std::size_t first, count;
+	};
+
+	std::vector<sf::Vertex> vertices;
+	std::vector<Run> runs;
+
+	static PrimitiveBatch*& Active() {
+		static PrimitiveBatch* active = nullptr;
+		return active;
+	}
+
+	sf::Vertex* Append(sf::PrimitiveType type, std::size_t count) {
+		if (runs.empty() || runs.back().type != type) runs.push_back({ type, vertices.size(), 0 });
+		runs.back().count += count;
+
+		vertices.resize(vertices.size() + count);
+		return &vertices[vertices.size() - count];
+	}
+public:
+	PrimitiveBatch() {}
+
+	~PrimitiveBatch() {
+		if (Active() == this) Active() = nullptr;
+	}
+
+	// Primitives drawn through the free Draw* functions are appended to the active batch
+	static PrimitiveBatch* GetActive() { return Active(); }
+
+	void Begin() {
+		Active() = this;
+	}
+
+	void End(RenderSurface& surface) {
+		Flush(surface);
+		if (Active() == this) Active() = nullptr;
+	}
+
+	void AddLine(float x1, float y1, float x2, float y2, sf::Color color = sf::Color::White) {
+		sf::Vertex* line = Append(sf::Lines, 2);
+		line[0] = sf::Vertex(sf::Vector2f(x1, y1), color);
+		line[1] = sf::Vertex(sf::Vector2f(x2, y2), color);
+	}
+
+	void AddPoint(float x, float y, sf::Color color = sf::Color::White) {
+		AddRect(x, y, 2.0f, 2.0f, color);
+	}
+
+	void AddQuad(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c, const sf::Vector2f& d, sf::Color color = sf::Color::White) {
+		sf::Vertex* quad = Append(sf::Quads, 4);
+		quad[0] = sf::Vertex(a, color);
+		quad[1] = sf::Vertex(b, color);
+		quad[2] = sf::Vertex(c, color);
+		quad[3] = sf::Vertex(d, color);
+	}
+
+	void AddRect(float x, float y, float w, float h, sf::Color color = sf::Color::White) {
+		AddQuad({ x, y }, { x + w, y }, { x + w, y + h }, { x, y + h }, color);
+	}
+
+	void Reserve(std::size_t nLines, std::size_t nPoints, std::size_t nQuads) {
+		vertices.reserve(nLines * 2 + nPoints * 4 + nQuads * 4);
+	}
+
+	// The buffers keep their capacity for the next frame
+	void Flush(RenderSurface& surface) {
+		for (auto& run : runs) {
+			surface.Draw(&vertices[run.first], run.count, run.type);
+		}
+
+		Clear();
+	}
+
+	void Clear() {
+		vertices.clear();
+		runs.clear();
+	}
+
+	inline bool IsEmpty() const { return runs.empty(); }
+};
+
+// Without an active batch the primitives are collected into a shared scratch batch and flushed at once
+class ScopedPrimitiveBatch {
+private:
+	RenderSurface& surface;
+	PrimitiveBatch* batch;
+	bool isOwner;
+
+	static PrimitiveBatch& Scratch() {
+		static PrimitiveBatch scratch;
+		return scratch;
+	}
+public:
+	ScopedPrimitiveBatch(RenderSurface& surface)
+		: surface(surface), batch(PrimitiveBatch::GetActive()), isOwner(false) {
+		if (!batch) {
+			batch = &Scratch();
+			isOwner = true;
+		}
+	}
+
+	~ScopedPrimitiveBatch() {
+		if (isOwner) batch->Flush(surface);
+	}
 
-void DrawPoint(sf::RenderWindow& window, float x, float y, sf::Color color = sf::Color::White) {
-	sf::RectangleShape pixel({ 2.0f, 2.0f });
-	pixel.setPosition({ x, y });
-	pixel.setFillColor(color);
+	PrimitiveBatch* operator->() { return batch; }
+};
+
+void DrawLine(RenderSurface& window, float x1, float y1, float x2, float y2, sf::Color color = sf::Color::White) {
+	ScopedPrimitiveBatch batch(window);
+	batch->AddLine(x1, y1, x2, y2, color);
+}
 
-	window.draw(pixel);
+void DrawPoint(RenderSurface& window, float x, float y, sf::Color color = sf::Color::White) {
+	ScopedPrimitiveBatch batch(window);
+	batch->AddPoint(x, y, color);
 }
 
-void DrawPolygon(sf::RenderWindow& window, const std::vector<sf::Vector2f>& points, sf::Color color = sf::Color::White) {
+void DrawPolygon(RenderSurface& window, const std::vector<sf::Vector2f>& points, sf::Color color = sf::Color::White) {
+	ScopedPrimitiveBatch batch(window);
 	for (std::size_t i = 1; i <= points.size(); i++) {
 		auto [x1, y1] = i == points.size() ? points[0] : points[i - 1];
 		auto [x2, y2] = i == points.size() ? points[points.size() - 1] : points[i];
 
-		DrawLine(window, x1, y1, x2, y2, color);
+		batch->AddLine(x1, y1, x2, y2, color);
 	}
 }
 
-void DrawGrid(sf::RenderWindow& window, float size, sf::Color color = sf::Color::White) {
-	auto [sizeX, sizeY] = window.getSize();
+void DrawGrid(RenderSurface& window, float size, sf::Color color = sf::Color::White) {
+	auto [sizeX, sizeY] = window.GetSize();
 
+	ScopedPrimitiveBatch batch(window);
 	for (uint32_t i = 0; i < sizeY / (uint32_t)size; i++) {
-		DrawLine(window, 0.0f, i * size, (float)sizeX, i * size, color);
+		batch->AddLine(0.0f, i * size, (float)sizeX, i * size, color);
 	}
 
 	for (uint32_t i = 0; i < sizeX / (uint32_t)size; i++) {
-		DrawLine(window, i * size, 0.0f, i * size, (float)sizeY, color);
+		batch->AddLine(i * size, 0.0f, i * size, (float)sizeY, color);
 	}
 }
 
-void DrawCircle(sf::RenderWindow& window, const sf::Vector2f& origin, float radius, sf::Color color = sf::Color::White) {
+void DrawCircle(RenderSurface& window, const sf::Vector2f& origin, float radius, sf::Color color = sf::Color::White) {
 	auto [h, k] = origin;
+
+	ScopedPrimitiveBatch batch(window);
 	for (float i = 1; i < 361; i++) {
 
 		float x = h + radius * cosf(i);
 		float y = k + radius * sinf(i);
 
-		DrawPoint(window, x, y, color);
+		batch->AddPoint(x, y, color);
 	}
 }
 
-void RenderText(sf::RenderWindow& window, const sf::Font& font, float x, float y, const std::string& str, sf::Color color = sf::Color::White, uint32_t characterSize = 32) {
+// Retained sf::Text that only re-formats and re-lays out its glyphs when the string, value, font or size changes
+class CachedText {
+private:
+	sf::Text text;
+	std::string label;
+	const sf::Font* font;
+	uint32_t characterSize;
+	float value;
+	bool hasValue;
+	char buffer[128];
+
+	bool SetLayout(const sf::Font& newFont, const std::string& str, uint32_t newCharacterSize) {
+		bool isChanged = false;
+
+		if (font != &newFont) {
+			font = &newFont;
+			text.setFont(newFont);
+		}
+
+		if (characterSize != newCharacterSize) {
+			characterSize = newCharacterSize;
+			text.setCharacterSize(newCharacterSize);
+		}
+
+		if (label != str) {
+			label = str;
+			isChanged = true;
+		}
+
+		return isChanged;
+	}
+public:
+	CachedText() {
+		font = nullptr;
+		characterSize = 0;
+		value = 0.0f;
+		hasValue = false;
+		buffer[0] = '\0';
+	}
+
+	void SetString(const sf::Font& newFont, const std::string& str, uint32_t newCharacterSize = 32) {
+		if (SetLayout(newFont, str, newCharacterSize) || hasValue) {
+			hasValue = false;
+			text.setString(label);
+		}
+	}
+
+	void SetStringWithValue(const sf::Font& newFont, const std::string& str, float newValue, uint32_t newCharacterSize = 32) {
+		if (!SetLayout(newFont, str, newCharacterSize) && hasValue && value == newValue) return;
+
+		hasValue = true;
+		value = newValue;
+
+		// Formats "<str> <value>" into the fixed buffer without going through a stream
+		const std::size_t capacity = sizeof(buffer) - 1;
+		std::size_t length = (std::min)(label.size(), capacity - 1);
+		std::memcpy(buffer, label.data(), length);
+		buffer[length++] = ' ';
+
+		auto result = std::to_chars(buffer + length, buffer + capacity, value);
+		length = result.ec == std::errc() ? (std::size_t)(result.ptr - buffer) : length;
+		buffer[length] = '\0';
+
+		text.setString(buffer);
+	}
+
+	void SetPosition(float x, float y) {
+		if (text.getPosition() != sf::Vector2f(x, y)) text.setPosition({ x, y });
+	}
+
+	void SetFillColor(sf::Color color) {
+		if (text.getFillColor() != color) text.setFillColor(color);
+	}
+
+	void Render(RenderSurface& surface) const {
+		PROFILE_ZONE("Text::Render");
+		surface.Draw(text);
+	}
+
+	inline const sf::Text& GetText() const { return text; }
+};
+
+void RenderText(RenderSurface& window, const sf::Font& font, float x, float y, const std::string& str, sf::Color color = sf::Color::White, uint32_t characterSize = 32) {
+	PROFILE_ZONE("Text::Render");
 	sf::Text text(str, font, characterSize);
 	text.setPosition({ x, y });
 	text.setFillColor(color);
 
-	window.draw(text);
+	window.Draw(text);
 }
 
-void DrawTextWithValue(sf::RenderWindow& window, const sf::Font& font, float x, float y, const std::string& str, float value, sf::Color color = sf::Color::White, uint32_t characterSize = 32) {
+void DrawTextWithValue(RenderSurface& window, const sf::Font& font, float x, float y, const std::string& str, float value, sf::Color color = sf::Color::White, uint32_t characterSize = 32) {
+	PROFILE_ZONE("Text::Render");
 	sf::Text text(str, font, characterSize);
 	text.setPosition({ x, y });
 	text.setFillColor(color);
@@ -185,5 +949,75 @@ void DrawTextWithValue(sf::RenderWindow& window, const sf::Font& font, float x,
 	ss << str << " " << value;
 	text.setString(ss.str());
 
-	window.draw(text);
+	window.Draw(text);
 }
+
+
+void RenderText(RenderSurface& window, CachedText& text, const sf::Font& font, float x, float y, const std::string& str, sf::Color color = sf::Color::White, uint32_t characterSize = 32) {
+	text.SetString(font, str, characterSize);
+	text.SetPosition(x, y);
+	text.SetFillColor(color);
+
+	text.Render(window);
+}
+
+void DrawTextWithValue(RenderSurface& window, CachedText& text, const sf::Font& font, float x, float y, const std::string& str, float value, sf::Color color = sf::Color::White, uint32_t characterSize = 32) {
+	text.SetStringWithValue(font, str, value, characterSize);
+	text.SetPosition(x, y);
+	text.SetFillColor(color);
+
+	text.Render(window);
+}
+
+#if PROFILER_ENABLED
+// Frame-time graph of the last Profiler::FrameHistory frames, frame percentiles and the
+// top-level zones of the last frame
+class ProfilerOverlay {
+private:
+	PrimitiveBatch batch;
+	CachedText summary;
+	std::vector<CachedText> zoneTexts, counterTexts;
+	std::vector<Profiler::Zone> zones;
+	float frameTimes[Profiler::FrameHistory];
+public:
+	void Render(RenderSurface& window, const sf::Font& font, float x = 0.0f, float y = 0.0f) {
+		const float graphHeight = 80.0f, msScale = graphHeight / 33.3f;
+		const uint32_t maxZones = 10;
+
+		Profiler& profiler = Profiler::Get();
+		uint32_t nFrames = profiler.GetFrameCount();
+		profiler.GetFrameTimes(frameTimes);
+		profiler.GetLastFrameZones(zones);
+
+		const std::vector<Profiler::Counter>& counters = profiler.GetCounters();
+		batch.AddRect(x, y, (float)Profiler::FrameHistory, graphHeight + 20.0f + (maxZones + counters.size()) * 16.0f, sf::Color(0, 0, 0, 180));
+		for (uint32_t i = 0; i < nFrames; i++) {
+			float barHeight = (std::min)(frameTimes[i] * msScale, graphHeight);
+			sf::Color color = frameTimes[i] > 16.7f ? sf::Color(230, 80, 60) : sf::Color(90, 200, 90);
+			batch.AddLine(x + i + 0.5f, y + graphHeight, x + i + 0.5f, y + graphHeight - barHeight, color);
+		}
+		batch.AddLine(x, y + graphHeight - 16.7f * msScale, x + Profiler::FrameHistory, y + graphHeight - 16.7f * msScale, sf::Color(255, 255, 255, 120));
+		batch.Flush(window);
+
+		char line[128];
+		std::snprintf(line, sizeof(line), "p50 %.2f  p95 %.2f  p99 %.2f ms", profiler.GetFramePercentile(0.5f), profiler.GetFramePercentile(0.95f), profiler.GetFramePercentile(0.99f));
+		RenderText(window, summary, font, x + 2.0f, y + graphHeight, line, sf::Color::White, 14);
+
+		uint32_t nShown = 0;
+		zoneTexts.resize(maxZones);
+		for (auto& zone : zones) {
+			if (zone.depth > 1 || nShown == maxZones) continue;
+
+			std::snprintf(line, sizeof(line), "%*s%s %.3f ms", (int)zone.depth * 2, "", zone.name, (zone.end - zone.start) / 1e6);
+			RenderText(window, zoneTexts[nShown], font, x + 2.0f, y + graphHeight + 18.0f + nShown * 16.0f, line, sf::Color::White, 12);
+			nShown++;
+		}
+
+		counterTexts.resize(counters.size());
+		for (std::size_t i = 0; i < counters.size(); i++) {
+			std::snprintf(line, sizeof(line), "%s %.2f", counters[i].name, counters[i].value);
+			RenderText(window, counterTexts[i], font, x + 2.0f, y + graphHeight + 18.0f + (maxZones + i) * 16.0f, line, sf::Color(255, 220, 120), 12);
+		}
+	}
+};
+#endif
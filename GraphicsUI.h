@@ -1,38 +1,44 @@
 #pragma once
-#include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/CircleShape.hpp>
 #include <SFML/Graphics/Texture.hpp>
-#include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Window/Event.hpp>
 #include <SFML/Graphics/Text.hpp>
 #include <sstream>
-#include <Windows.h>
+#include "Profiler.h"
+#include "UIRouter.h"
+#include "GapBuffer.h"
+#include "RenderSurface.h"
+#include "WidgetTree.h"
+#include <vector>
 using namespace sf;
 
+// The bar is a box in a WidgetTree, which draws it with the rest of the screen; the knob is a circle
+// the slider draws over the tree in Render
 class Slider {
 private:
-	RectangleShape sliderBar;
+	WidgetTree* tree;
+	uint32_t bar;
 	CircleShape circle;
 
 	int value;
 public:
-	Slider() {}
-	Slider(const Vector2f& pos, const Vector2f& sliderBarSize, const float radius, const Color& sliderBarColor, const Color& circleColor) {
-		sliderBar.setSize(sliderBarSize);
-		sliderBar.setPosition(pos);
-		sliderBar.setFillColor(sliderBarColor);
+	Slider() {
+		tree = nullptr;
+		bar = 0;
+		value = 0;
+	}
 
-		circle.setRadius(radius);
-		circle.setOrigin({ radius / 2.0f, radius / 2.0f });
-		circle.setFillColor(circleColor);
-		circle.setPosition(pos);
+	Slider(WidgetTree& widgetTree, const Vector2f& pos, const Vector2f& sliderBarSize, const float radius, const Color& sliderBarColor, const Color& circleColor)
+		: Slider() {
+		Initialize(widgetTree, pos, sliderBarSize, radius, sliderBarColor, circleColor);
 	}
 
-	void Initialize(const Vector2f& pos, const Vector2f& sliderBarSize, const float radius, const Color& sliderBarColor, const Color& circleColor) {
-		sliderBar.setSize(sliderBarSize);
-		sliderBar.setPosition(pos);
-		sliderBar.setFillColor(sliderBarColor);
+	void Initialize(WidgetTree& widgetTree, const Vector2f& pos, const Vector2f& sliderBarSize, const float radius, const Color& sliderBarColor, const Color& circleColor) {
+		tree = &widgetTree;
+		value = 0;
+
+		bar = tree->Add(-1, pos, sliderBarSize, sliderBarColor);
 
 		circle.setRadius(radius);
 		circle.setOrigin({ radius / 2.0f, radius / 2.0f });
@@ -40,16 +46,17 @@ public:
 		circle.setPosition(pos);
 	}
 
-	void SetTexture(Texture& texture) {
-		sliderBar.setFillColor(Color::White);
-		sliderBar.setTexture(&texture);
+	void SetTexture(const Texture& texture, const IntRect& textureRect = IntRect()) {
+		tree->SetFillColor(bar, Color::White);
+		tree->SetTexture(bar, &texture, textureRect);
 	}
 
 	inline int GetValue() const { return value; }
 
 	void Logic(Vector2f mousePos) {
-		float sliderLeft = sliderBar.getPosition().x;
-		float sliderRight = sliderBar.getPosition().x + sliderBar.getSize().x;
+		sf::FloatRect barBounds = tree->GetBounds(bar);
+		float sliderLeft = barBounds.left;
+		float sliderRight = barBounds.left + barBounds.width;
 
 		if (circle.getGlobalBounds().contains(mousePos)) {
 			if (mousePos.x >= sliderLeft && mousePos.x <= sliderRight) {
@@ -60,195 +67,232 @@ public:
 		}
 	}
 
-	void Render(RenderWindow& window) {
-		window.draw(sliderBar);
-		window.draw(circle);
+	// Draws the knob; the bar is drawn by the tree, which has to be rendered first
+	void Render(RenderSurface& window) {
+		PROFILE_ZONE("Slider::Render");
+		window.Draw(circle);
 	}
 };
 
-class Button {
+// Editable text field. Text lives in a GapBuffer and every character keeps its glyph quad and pen
+// origin, so an edit re-places glyphs only from the edit to the end of its line; the lines below are
+// left alone, or shifted vertically when the edit added or removed a line break. The box and cursor
+// are WidgetTree nodes; the glyphs are the text box's own batch, drawn over the tree by Render
+class TextBox {
 private:
-	RectangleShape buttonBox;
-	Color colors[3];
-	bool isTexture, onPress, isButtonPressed;
-
-	void OnMousePress(Vector2f& mousePos) {
-		if (IsPositionInBounds(mousePos)) {
-			buttonBox.setFillColor(colors[MousePressed]);
-			onPress = true;
-		}
-	}
+	struct GlyphQuad {
+		Vertex vertices[4];
+	};
 
-	void OnMouseHover(Vector2f& mousePos) {
-		if (IsPositionInBounds(mousePos)) {
-			buttonBox.setFillColor(colors[MouseHover]);
-		}
-	}
+	WidgetTree* tree;
+	uint32_t box, cursorBar; // cursorBar is a child of box
+	Vector2f position;
 
-	void OnMouseRelease(Vector2f& mousePos) {
-		if (IsPositionInBounds(mousePos)) {
-			buttonBox.setFillColor(colors[MouseRelease]);
-			onPress = false;
-		}
+	// Per character, all with the gap at the cursor
+	GapBuffer<char> buffer;
+	GapBuffer<GlyphQuad> glyphs;
+	GapBuffer<Vector2f> origins; // Pen position (left, baseline) the character was placed at
+	const Font* font;
+	uint32_t characterSize;
+	Color color;
+
+	bool isSelected, isMultiline;
+
+	float GetLineSpacing() const {
+		return font ? font->getLineSpacing(characterSize) : (float)characterSize;
 	}
 
-public:
-	Button() {}
-	
-	Button(const Vector2f& pos, const Vector2f& buttonBoxSize) {
-		buttonBox.setSize(buttonBoxSize);
-		buttonBox.setPosition(pos);
-	
-		isTexture = false;
-		onPress = false;
-		isButtonPressed = false;
-	}
-
-	enum ButtonState {
-		MousePressed = 0,
-		MouseHover = 1,
-		MouseRelease = 2
-	};
-	
-	bool IsPositionInBounds(Vector2f& position) {
-		return buttonBox.getGlobalBounds().contains(position);
+	Vector2f GetFirstOrigin() const {
+		return { position.x, position.y + characterSize };
 	}
 
-	void ResetColor() {
-		buttonBox.setFillColor(colors[2]);
+	// Pen position after character i
+	Vector2f GetNextOrigin(std::size_t i) const {
+		if (buffer[i] == '\n') return { GetFirstOrigin().x, origins[i].y + GetLineSpacing() };
+		return { origins[i].x + (font ? font->getGlyph((uint8_t)buffer[i], characterSize, false).advance : 0.0f), origins[i].y };
 	}
 
-	void Initialize(const Vector2f& pos, const Vector2f& buttonBoxSize) {
-		buttonBox.setSize(buttonBoxSize);
-		buttonBox.setPosition(pos);
+	void PlaceGlyph(std::size_t i, Vector2f origin) {
+		uint32_t c = (uint8_t)buffer[i];
+		if (font && i > 0 && buffer[i - 1] != '\n') origin.x += font->getKerning((uint8_t)buffer[i - 1], c, characterSize);
+		origins[i] = origin;
+
+		Vertex* quad = glyphs[i].vertices;
+		if (!font || c == '\n') {
+			for (int k = 0; k < 4; k++) quad[k] = Vertex(origin, Color::Transparent);
+			return;
+		}
+
+		const Glyph& glyph = font->getGlyph(c, characterSize, false);
+		float left = origin.x + glyph.bounds.left, top = origin.y + glyph.bounds.top;
+		float right = left + glyph.bounds.width, bottom = top + glyph.bounds.height;
+		float u1 = (float)glyph.textureRect.left, v1 = (float)glyph.textureRect.top;
+		float u2 = u1 + glyph.textureRect.width, v2 = v1 + glyph.textureRect.height;
+
+		quad[0] = Vertex({ left, top }, Color::White, { u1, v1 });
+		quad[1] = Vertex({ right, top }, Color::White, { u2, v1 });
+		quad[2] = Vertex({ right, bottom }, Color::White, { u2, v2 });
+		quad[3] = Vertex({ left, bottom }, Color::White, { u1, v2 });
 	}
 
-	void SetOutline(float thickness, const Color& color) {
-		buttonBox.setOutlineThickness(thickness);
-		buttonBox.setOutlineColor(color);
+	// Re-places characters from 'from' up to the first line that started a line before the edit as well;
+	// from there on the layout is unchanged apart from a vertical shift
+	void Relayout(std::size_t from) {
+		std::size_t size = buffer.GetSize();
+		Vector2f origin = from == 0 ? GetFirstOrigin() : GetNextOrigin(from - 1);
+
+		for (std::size_t i = from; i < size; i++) {
+			if (i > from && buffer[i - 1] == '\n' && origins[i].x == GetFirstOrigin().x) {
+				float shift = origin.y - origins[i].y;
+				if (shift == 0.0f) break;
+
+				for (std::size_t k = i; k < size; k++) {
+					origins[k].y += shift;
+					for (auto& vertex : glyphs[k].vertices) vertex.position.y += shift;
+				}
+				break;
+			}
+
+			PlaceGlyph(i, origin);
+			origin = GetNextOrigin(i);
+		}
+
+		UpdateCursor();
 	}
 
-	void SetColors(const Color& onPress, const Color& onHover, const Color& onRelease) {
-		colors[MousePressed] = onPress;
-		colors[MouseHover] = onHover;
-		colors[MouseRelease] = onRelease;
+	void RelayoutAll() {
+		Vector2f origin = GetFirstOrigin();
+		for (std::size_t i = 0; i < buffer.GetSize(); i++) {
+			PlaceGlyph(i, origin);
+			origin = GetNextOrigin(i);
+		}
+
+		UpdateCursor();
 	}
 
-	void SetFillColor(const sf::Color& color) {
-		buttonBox.setFillColor(color);
+	void UpdateCursor() {
+		if (!tree) return;
+
+		std::size_t cursor = buffer.GetCursor();
+		Vector2f origin = cursor < buffer.GetSize() ? origins[cursor] : cursor > 0 ? GetNextOrigin(cursor - 1) : GetFirstOrigin();
+
+		tree->SetSize(cursorBar, { 2.0f, (float)characterSize });
+		tree->SetPosition(cursorBar, { origin.x - position.x, origin.y - characterSize - position.y });
 	}
 
-	bool GetIsPressed() { 
-		if (!onPress) isButtonPressed = false;
+	void Insert(char c) {
+		std::size_t cursor = buffer.GetCursor();
+		buffer.Insert(c);
+		glyphs.Insert(GlyphQuad());
+		origins.Insert(Vector2f());
+		Relayout(cursor);
+	}
 
-		if (onPress && !isButtonPressed) {
-			isButtonPressed = true;
-			return true;
-		}
+	void Erase() {
+		if (!buffer.Erase()) return;
 
-		return false;
+		glyphs.Erase();
+		origins.Erase();
+		Relayout(buffer.GetCursor());
 	}
-	inline sf::Color const* GetColors() const { return colors; }
 
-	inline sf::Vector2f GetPosition() const { return buttonBox.getPosition(); }
+	void Delete() {
+		if (!buffer.Delete()) return;
 
-	void SetPosition(const sf::Vector2f& pos) {
-		buttonBox.setPosition(pos);
+		glyphs.Delete();
+		origins.Delete();
+		Relayout(buffer.GetCursor());
 	}
 
-	bool SetTexture(Texture& texture) {
-		if (texture.getSize().x > buttonBox.getSize().x && texture.getSize().y > buttonBox.getSize().y) {
-			buttonBox.setTexture(&texture);
-			isTexture = true;
-			
-			return true;
-		}
+	void MoveCursor(std::size_t position) {
+		buffer.MoveCursor(position);
+		glyphs.MoveCursor(position);
+		origins.MoveCursor(position);
+		UpdateCursor();
+	}
 
-		return false;
+	// Keeps the column when moving between lines, clamped to the length of the target line
+	void MoveCursorLine(bool isDown) {
+		std::size_t cursor = buffer.GetCursor();
+		std::size_t lineStart = buffer.GetLineStart(cursor), column = cursor - lineStart;
+
+		if (isDown) {
+			std::size_t lineEnd = buffer.GetLineEnd(cursor);
+			if (lineEnd == buffer.GetSize()) return;
+			MoveCursor((std::min)(lineEnd + 1 + column, buffer.GetLineEnd(lineEnd + 1)));
+		}
+		else {
+			if (lineStart == 0) return;
+			std::size_t prevStart = buffer.GetLineStart(lineStart - 1);
+			MoveCursor((std::min)(prevStart + column, lineStart - 1));
+		}
 	}
 
-	void Logic(Event e, Vector2f& mousePos) {
-		if (!onPress) {
-			ResetColor();	
+	// Character index closest to a point inside the box
+	std::size_t FindPosition(const Vector2f& point) const {
+		std::size_t size = buffer.GetSize(), i = 0;
+		float lineSpacing = GetLineSpacing();
+
+		float baseline = GetFirstOrigin().y;
+		while (i < size && point.y > baseline + lineSpacing - characterSize) {
+			std::size_t lineEnd = buffer.GetLineEnd(i);
+			if (lineEnd == size) break;
+			i = lineEnd + 1;
+			baseline += lineSpacing;
 		}
 
-		switch (e.type) {
-		case Event::MouseButtonPressed:
-			switch (e.key.code) {
-			case Mouse::Left:
-				OnMousePress(mousePos);
-				break;
-			}
-			break;
-		case Event::MouseButtonReleased:
-			switch (e.key.code) {
-			case Mouse::Left:
-				OnMouseRelease(mousePos);
-				break;
-			}
-			break;
-		case sf::Event::MouseMoved:
-			if (!onPress) OnMouseHover(mousePos);
-			break;
+		for (; i < size && buffer[i] != '\n'; i++) {
+			float middle = (origins[i].x + GetNextOrigin(i).x) / 2.0f;
+			if (point.x < middle) break;
 		}
+		return i;
 	}
 
-	void Render(RenderWindow& window) {
-		window.draw(buttonBox);
+	void SetSelected(bool selected) {
+		isSelected = selected;
+		tree->SetFillColor(box, isSelected ? Color(color.r + 25, color.g + 25, color.b + 25) : color);
+		tree->SetVisible(cursorBar, isSelected);
 	}
-};
-
-class TextBox {
-private:
-	RectangleShape box;
-	std::ostringstream textStr;
-	Text text;
-	Color color;
-
-	bool isSelected;
 
-	void Input(uint32_t str) {
-		if (isSelected) {
-			if (str == 0x08 || str == 0x2E) {
-				if (textStr.str().size() > 0) {
-					const std::string& initStr = textStr.str();
-					std::string newStr;
+	void Input(uint32_t c) {
+		if (!isSelected) return;
 
-					for (std::size_t i = 0; i < initStr.size() - 1; i++) {
-						newStr += initStr[i];
-					}
-
-					textStr.str("");
-					textStr << newStr;
-				}
-			}
-			else if (str < 128) {
-				textStr << static_cast<char>(str);
-			}
+		if (c == 0x08) Erase();
+		else if (c == 0x7F) Delete();
+		else if (c == '\r') {
+			if (isMultiline) Insert('\n');
+		}
+		else if (c >= 32 && c < 128) {
+			Insert(static_cast<char>(c));
 		}
 	}
 public:
-	TextBox() {}
-	TextBox(const sf::Vector2f& position, const sf::Vector2f& textBoxSize, sf::Color textBoxColor = sf::Color::Black) 
-		: color(textBoxColor) {
-		box.setSize(textBoxSize);
-		box.setPosition(position);
-		box.setFillColor(textBoxColor);
-	
+	TextBox() {
+		tree = nullptr;
+		box = 0;
+		cursorBar = 0;
+		font = nullptr;
+		characterSize = 30;
 		isSelected = false;
+		isMultiline = false;
 	}
 
-	void Initialize(const sf::Vector2f& position, const sf::Vector2f& textBoxSize, sf::Color textBoxColor = sf::Color::Black) {
+	TextBox(WidgetTree& widgetTree, const sf::Vector2f& position, const sf::Vector2f& textBoxSize, sf::Color textBoxColor = sf::Color::Black) 
+		: TextBox() {
+		Initialize(widgetTree, position, textBoxSize, textBoxColor);
+	}
 
+	void Initialize(WidgetTree& widgetTree, const sf::Vector2f& position, const sf::Vector2f& textBoxSize, sf::Color textBoxColor = sf::Color::Black) {
+		tree = &widgetTree;
+		this->position = position;
 		color = textBoxColor;
 
-		box.setSize(textBoxSize);
-		box.setPosition(position);
-		box.setFillColor(textBoxColor);
-
-		text.setPosition(position);
+		box = tree->Add(-1, position, textBoxSize, textBoxColor);
+		cursorBar = tree->Add(box, { 0.0f, 0.0f }, { 2.0f, (float)characterSize }, Color::White);
+		tree->SetVisible(cursorBar, false);
 
 		isSelected = false;
+		RelayoutAll();
 	}
 
 	void Logic(sf::Event e) {
@@ -257,48 +301,102 @@ public:
 			Input(e.text.unicode);
 			break;
 		case sf::Event::MouseButtonPressed:
+			switch (e.mouseButton.button) {
+			case sf::Mouse::Left: {
+				Vector2f point((float)e.mouseButton.x, (float)e.mouseButton.y);
+				SetSelected(tree->GetBounds(box).contains(point));
+				if (isSelected) MoveCursor(FindPosition(point));
+				break;
+			}
+			}
+			break;
+		case sf::Event::KeyPressed:
+			if (!isSelected) break;
+
 			switch (e.key.code) {
-			case sf::Mouse::Left:
-				
-				isSelected = false;
-				
-				if (box.getGlobalBounds().contains(Vector2f((float)e.mouseButton.x, (float)e.mouseButton.y))) {
-					isSelected = true;
-				}
+			case sf::Keyboard::Left:
+				if (buffer.GetCursor() > 0) MoveCursor(buffer.GetCursor() - 1);
+				break;
+			case sf::Keyboard::Right:
+				MoveCursor(buffer.GetCursor() + 1);
+				break;
+			case sf::Keyboard::Up:
+				MoveCursorLine(false);
+				break;
+			case sf::Keyboard::Down:
+				MoveCursorLine(true);
+				break;
+			case sf::Keyboard::Home:
+				MoveCursor(buffer.GetLineStart(buffer.GetCursor()));
+				break;
+			case sf::Keyboard::End:
+				MoveCursor(buffer.GetLineEnd(buffer.GetCursor()));
 				break;
 			}
 			break;
 		case sf::Event::KeyReleased:
 			switch (e.key.code) {
 			case sf::Keyboard::Return:
-				if (isSelected) isSelected = false;
-				textStr.str("");
+				if (isMultiline) break;
+
+				if (isSelected) SetSelected(false);
+				Clear();
 				break;
 			}
 			break;
 		}
-
-		box.setFillColor(isSelected ? Color(color.r + 25, color.g + 25, color.b + 25) : color);
-		text.setString(textStr.str() + (isSelected ? "_" : ""));
 	}
 
 	bool GetIsSelected() const { return isSelected; }
 
 	std::string GetString() const {
-		return textStr.str();
+		return buffer.ToString();
+	}
+
+	void SetString(const std::string& str) {
+		Clear();
+		buffer.Insert(str.data(), str.size());
+		std::vector<GlyphQuad> quads(str.size());
+		glyphs.Insert(quads.data(), quads.size());
+		std::vector<Vector2f> positions(str.size());
+		origins.Insert(positions.data(), positions.size());
+		RelayoutAll();
+	}
+
+	void Clear() {
+		buffer.Clear();
+		glyphs.Clear();
+		origins.Clear();
+		UpdateCursor();
+	}
+
+	// Return inserts a line break instead of submitting and clearing the text
+	void SetMultiline(bool multiline) {
+		isMultiline = multiline;
 	}
 
 	void SetPosition(const sf::Vector2f& pos) {
-		box.setPosition(pos);
-		text.setPosition(pos);
+		position = pos;
+		tree->SetPosition(box, pos);
+		RelayoutAll();
 	}
 
-	void SetFont(const Font& font) {
-		text.setFont(font);
+	void SetFont(const Font& newFont) {
+		font = &newFont;
+		RelayoutAll();
 	}
 
-	void Render(RenderWindow& window) {
-		window.draw(box);
-		window.draw(text);
+	void SetCharacterSize(uint32_t newCharacterSize) {
+		characterSize = newCharacterSize;
+		RelayoutAll();
+	}
+
+	// Render the tree first; this only draws the glyphs
+	void Render(RenderSurface& window) {
+		if (font) {
+			RenderStates states(&font->getTexture(characterSize));
+			if (glyphs.GetFrontSize()) window.Draw(glyphs.GetFront()->vertices, glyphs.GetFrontSize() * 4, sf::Quads, states);
+			if (glyphs.GetBackSize()) window.Draw(glyphs.GetBack()->vertices, glyphs.GetBackSize() * 4, sf::Quads, states);
+		}
 	}
 };
@@ -0,0 +1,406 @@
+#pragma once
+#include <SFML/Window/Event.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+
+// Journal layout: JournalHeader, then records of [kind][varint microseconds since the previous record].
+// Event records continue with the zigzag mouse position delta and an event-specific payload;
+// frame records continue with the number of simulation ticks run that frame
+struct JournalHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t seed;
+	uint32_t tickRate;
+	uint16_t boardColumns, boardRows; // 0 in journals written before boards were configurable, meaning 2x2
+};
+
+constexpr char JournalMagic[4] = { 'T', 'C', 'I', 'J' };
+constexpr uint32_t JournalVersion = 1;
+constexpr uint8_t JournalFrameKind = 0xFF;
+
+struct JournalEntry {
+	enum Type {
+		Event = 0,
+		Frame = 1
+	} type;
+
+	uint64_t time; //Microseconds since recording started
+	sf::Event event;
+	sf::Vector2f mousePos;
+	uint32_t nTicks;
+};
+
+namespace JournalEncoding {
+	inline uint8_t* WriteVarint(uint8_t* out, uint64_t value) {
+		while (value >= 0x80) {
+			*out++ = (uint8_t)(value | 0x80);
+			value >>= 7;
+		}
+		*out++ = (uint8_t)value;
+		return out;
+	}
+
+	inline uint8_t* WriteSigned(uint8_t* out, int64_t value) {
+		return WriteVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+	}
+
+	inline bool ReadVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value) {
+		value = 0;
+		for (int shift = 0; in < end && shift < 64; shift += 7) {
+			uint8_t byte = *in++;
+			value |= (uint64_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return true;
+		}
+		return false;
+	}
+
+	inline bool ReadSigned(const uint8_t*& in, const uint8_t* end, int64_t& value) {
+		uint64_t raw;
+		if (!ReadVarint(in, end, raw)) return false;
+		value = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+		return true;
+	}
+}
+
+// Single-producer single-consumer byte queue; writes are all-or-nothing
+class ByteRingBuffer {
+private:
+	std::unique_ptr<uint8_t[]> buffer;
+	std::size_t capacity, mask;
+
+	alignas(64) std::atomic<std::size_t> head; //Total bytes written by the producer
+	alignas(64) std::atomic<std::size_t> tail; //Total bytes read by the consumer
+public:
+	// capacity is rounded up to a power of two
+	explicit ByteRingBuffer(std::size_t minCapacity = 1 << 16) {
+		capacity = 1;
+		while (capacity < minCapacity) capacity <<= 1;
+		mask = capacity - 1;
+
+		buffer.reset(new uint8_t[capacity]);
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+	}
+
+	bool Push(const uint8_t* data, std::size_t size) {
+		std::size_t write = head.load(std::memory_order_relaxed);
+		if (capacity - (write - tail.load(std::memory_order_acquire)) < size) return false;
+
+		std::size_t first = (std::min)(size, capacity - (write & mask));
+		std::memcpy(&buffer[write & mask], data, first);
+		std::memcpy(&buffer[0], data + first, size - first);
+
+		head.store(write + size, std::memory_order_release);
+		return true;
+	}
+
+	std::size_t Pop(uint8_t* out, std::size_t maxSize) {
+		std::size_t read = tail.load(std::memory_order_relaxed);
+		std::size_t size = (std::min)(maxSize, head.load(std::memory_order_acquire) - read);
+
+		std::size_t first = (std::min)(size, capacity - (read & mask));
+		std::memcpy(out, &buffer[read & mask], first);
+		std::memcpy(out + first, &buffer[0], size - first);
+
+		tail.store(read + size, std::memory_order_release);
+		return size;
+	}
+};
+
+// Encodes events on the game thread into a lock-free ring; a background thread drains it to disk
+class InputRecorder {
+private:
+	ByteRingBuffer ring;
+	std::ofstream file;
+	std::thread writer;
+	std::atomic<bool> isRunning;
+
+	std::chrono::steady_clock::time_point start;
+	uint64_t lastTime;
+	int lastMouseX, lastMouseY;
+
+	void WriterLoop() {
+		std::vector<uint8_t> chunk(1 << 16);
+
+		while (true) {
+			bool isStopping = !isRunning.load(std::memory_order_acquire);
+
+			std::size_t size = ring.Pop(chunk.data(), chunk.size());
+			if (size > 0) file.write(reinterpret_cast<const char*>(chunk.data()), size);
+			else if (isStopping) break;
+			else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		file.flush();
+	}
+
+	uint8_t* WriteTime(uint8_t* out) {
+		uint64_t now = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		out = JournalEncoding::WriteVarint(out, now - lastTime);
+		lastTime = now;
+		return out;
+	}
+
+	void Push(const uint8_t* data, std::size_t size) {
+		while (!ring.Push(data, size)) {
+			std::this_thread::yield();
+		}
+	}
+public:
+	InputRecorder() : ring(1 << 20), isRunning(false) {
+		lastTime = 0;
+		lastMouseX = lastMouseY = 0;
+	}
+
+	InputRecorder(const InputRecorder&) = delete;
+	InputRecorder& operator=(const InputRecorder&) = delete;
+
+	bool Open(const std::string& filepath, uint64_t seed, uint32_t tickRate, uint32_t boardColumns = 2, uint32_t boardRows = 2) {
+		Close();
+
+		file.open(filepath, std::ios::binary);
+		if (!file.is_open()) return false;
+
+		JournalHeader header;
+		std::memcpy(header.magic, JournalMagic, sizeof(JournalMagic));
+		header.version = JournalVersion;
+		header.seed = seed;
+		header.tickRate = tickRate;
+		header.boardColumns = (uint16_t)boardColumns;
+		header.boardRows = (uint16_t)boardRows;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		start = std::chrono::steady_clock::now();
+		lastTime = 0;
+		lastMouseX = lastMouseY = 0;
+
+		isRunning.store(true, std::memory_order_release);
+		writer = std::thread(&InputRecorder::WriterLoop, this);
+		return true;
+	}
+
+	void RecordEvent(const sf::Event& event, sf::Vector2f mousePos) {
+		using namespace JournalEncoding;
+
+		uint8_t record[64];
+		uint8_t* out = record;
+
+		*out++ = (uint8_t)event.type;
+		out = WriteTime(out);
+
+		int mouseX = (int)mousePos.x, mouseY = (int)mousePos.y;
+		out = WriteSigned(out, mouseX - lastMouseX);
+		out = WriteSigned(out, mouseY - lastMouseY);
+		lastMouseX = mouseX;
+		lastMouseY = mouseY;
+
+		switch (event.type) {
+		case sf::Event::Resized:
+			out = WriteVarint(out, event.size.width);
+			out = WriteVarint(out, event.size.height);
+			break;
+		case sf::Event::TextEntered:
+			out = WriteVarint(out, event.text.unicode);
+			break;
+		case sf::Event::KeyPressed:
+		case sf::Event::KeyReleased:
+			out = WriteSigned(out, event.key.code);
+			*out++ = (uint8_t)(event.key.alt | (event.key.control << 1) | (event.key.shift << 2) | (event.key.system << 3));
+			break;
+		case sf::Event::MouseWheelMoved:
+			out = WriteSigned(out, event.mouseWheel.delta);
+			out = WriteSigned(out, event.mouseWheel.x - mouseX);
+			out = WriteSigned(out, event.mouseWheel.y - mouseY);
+			break;
+		case sf::Event::MouseWheelScrolled:
+			*out++ = (uint8_t)event.mouseWheelScroll.wheel;
+			std::memcpy(out, &event.mouseWheelScroll.delta, sizeof(float));
+			out += sizeof(float);
+			out = WriteSigned(out, event.mouseWheelScroll.x - mouseX);
+			out = WriteSigned(out, event.mouseWheelScroll.y - mouseY);
+			break;
+		case sf::Event::MouseButtonPressed:
+		case sf::Event::MouseButtonReleased:
+			out = WriteVarint(out, event.mouseButton.button);
+			out = WriteSigned(out, event.mouseButton.x - mouseX);
+			out = WriteSigned(out, event.mouseButton.y - mouseY);
+			break;
+		case sf::Event::MouseMoved:
+			out = WriteSigned(out, event.mouseMove.x - mouseX);
+			out = WriteSigned(out, event.mouseMove.y - mouseY);
+			break;
+		default:
+			break;
+		}
+
+		Push(record, out - record);
+	}
+
+	void RecordFrame(uint32_t nTicks) {
+		uint8_t record[24];
+		uint8_t* out = record;
+
+		*out++ = JournalFrameKind;
+		out = WriteTime(out);
+		out = JournalEncoding::WriteVarint(out, nTicks);
+
+		Push(record, out - record);
+	}
+
+	inline bool IsOpen() const { return file.is_open(); }
+
+	void Close() {
+		if (writer.joinable()) {
+			isRunning.store(false, std::memory_order_release);
+			writer.join();
+		}
+		if (file.is_open()) file.close();
+	}
+
+	~InputRecorder() {
+		Close();
+	}
+};
+
+class InputJournalReader {
+private:
+	std::vector<uint8_t> data;
+	const uint8_t* cursor;
+	const uint8_t* end;
+	JournalHeader header;
+
+	uint64_t time;
+	int mouseX, mouseY;
+public:
+	InputJournalReader() {
+		cursor = end = nullptr;
+		std::memset(&header, 0, sizeof(header));
+		time = 0;
+		mouseX = mouseY = 0;
+	}
+
+	bool Open(const std::string& filepath) {
+		std::ifstream reader(filepath, std::ios::binary);
+		if (!reader.is_open()) return false;
+
+		data.assign(std::istreambuf_iterator<char>(reader), std::istreambuf_iterator<char>());
+		if (data.size() < sizeof(JournalHeader)) return false;
+
+		std::memcpy(&header, data.data(), sizeof(header));
+		if (std::memcmp(header.magic, JournalMagic, sizeof(JournalMagic)) != 0 || header.version != JournalVersion) return false;
+
+		cursor = data.data() + sizeof(JournalHeader);
+		end = data.data() + data.size();
+		time = 0;
+		mouseX = mouseY = 0;
+		return true;
+	}
+
+	inline uint64_t GetSeed() const { return header.seed; }
+	inline uint32_t GetTickRate() const { return header.tickRate; }
+	inline uint32_t GetBoardColumns() const { return header.boardColumns ? header.boardColumns : 2; }
+	inline uint32_t GetBoardRows() const { return header.boardRows ? header.boardRows : 2; }
+
+	// Returns false at the end of the journal or on a truncated record
+	bool Next(JournalEntry& entry) {
+		using namespace JournalEncoding;
+
+		if (cursor >= end) return false;
+
+		uint8_t kind = *cursor++;
+		uint64_t delta;
+		if (!ReadVarint(cursor, end, delta)) return false;
+		time += delta;
+		entry.time = time;
+
+		if (kind == JournalFrameKind) {
+			uint64_t nTicks;
+			if (!ReadVarint(cursor, end, nTicks)) return false;
+
+			entry.type = JournalEntry::Frame;
+			entry.nTicks = (uint32_t)nTicks;
+			return true;
+		}
+
+		int64_t dx, dy;
+		if (!ReadSigned(cursor, end, dx) || !ReadSigned(cursor, end, dy)) return false;
+		mouseX += (int)dx;
+		mouseY += (int)dy;
+
+		entry.type = JournalEntry::Event;
+		entry.mousePos = sf::Vector2f((float)mouseX, (float)mouseY);
+		std::memset(&entry.event, 0, sizeof(entry.event));
+		entry.event.type = (sf::Event::EventType)kind;
+
+		uint64_t a = 0, b = 0;
+		int64_t x = 0, y = 0, value = 0;
+		bool isValid = true;
+
+		switch (entry.event.type) {
+		case sf::Event::Resized:
+			isValid = ReadVarint(cursor, end, a) && ReadVarint(cursor, end, b);
+			entry.event.size.width = (unsigned)a;
+			entry.event.size.height = (unsigned)b;
+			break;
+		case sf::Event::TextEntered:
+			isValid = ReadVarint(cursor, end, a);
+			entry.event.text.unicode = (uint32_t)a;
+			break;
+		case sf::Event::KeyPressed:
+		case sf::Event::KeyReleased:
+			isValid = ReadSigned(cursor, end, value) && cursor < end;
+			if (isValid) {
+				uint8_t flags = *cursor++;
+				entry.event.key.code = (sf::Keyboard::Key)value;
+				entry.event.key.alt = (flags & 1) != 0;
+				entry.event.key.control = (flags & 2) != 0;
+				entry.event.key.shift = (flags & 4) != 0;
+				entry.event.key.system = (flags & 8) != 0;
+			}
+			break;
+		case sf::Event::MouseWheelMoved:
+			isValid = ReadSigned(cursor, end, value) && ReadSigned(cursor, end, x) && ReadSigned(cursor, end, y);
+			entry.event.mouseWheel.delta = (int)value;
+			entry.event.mouseWheel.x = mouseX + (int)x;
+			entry.event.mouseWheel.y = mouseY + (int)y;
+			break;
+		case sf::Event::MouseWheelScrolled:
+			isValid = end - cursor >= 1 + (std::ptrdiff_t)sizeof(float);
+			if (isValid) {
+				entry.event.mouseWheelScroll.wheel = (sf::Mouse::Wheel)*cursor++;
+				std::memcpy(&entry.event.mouseWheelScroll.delta, cursor, sizeof(float));
+				cursor += sizeof(float);
+				isValid = ReadSigned(cursor, end, x) && ReadSigned(cursor, end, y);
+				entry.event.mouseWheelScroll.x = mouseX + (int)x;
+				entry.event.mouseWheelScroll.y = mouseY + (int)y;
+			}
+			break;
+		case sf::Event::MouseButtonPressed:
+		case sf::Event::MouseButtonReleased:
+			isValid = ReadVarint(cursor, end, a) && ReadSigned(cursor, end, x) && ReadSigned(cursor, end, y);
+			entry.event.mouseButton.button = (sf::Mouse::Button)a;
+			entry.event.mouseButton.x = mouseX + (int)x;
+			entry.event.mouseButton.y = mouseY + (int)y;
+			break;
+		case sf::Event::MouseMoved:
+			isValid = ReadSigned(cursor, end, x) && ReadSigned(cursor, end, y);
+			entry.event.mouseMove.x = mouseX + (int)x;
+			entry.event.mouseMove.y = mouseY + (int)y;
+			break;
+		default:
+			break;
+		}
+
+		return isValid;
+	}
+};
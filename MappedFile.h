@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. A copy-on-write mapping may also be written to;
+// touched pages become private to the process and the file itself is never modified
+class MappedFile {
+private:
+	uint8_t* data;
+	std::size_t dataSize;
+	bool isCopyOnWrite;
+
+#ifdef _WIN32
+	HANDLE file, mapping;
+#else
+	int file;
+#endif
+public:
+	MappedFile() {
+		data = nullptr;
+		dataSize = 0;
+		isCopyOnWrite = false;
+#ifdef _WIN32
+		file = mapping = nullptr;
+#else
+		file = -1;
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Fails without a message if the file is missing or empty
+	bool Open(const std::string& filepath, bool copyOnWrite = false) {
+		Close();
+		isCopyOnWrite = copyOnWrite;
+
+#ifdef _WIN32
+		file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			file = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+			dataSize = (std::size_t)size.QuadPart;
+
+			mapping = CreateFileMappingA(file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+			if (mapping) data = static_cast<uint8_t*>(MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+		}
+#else
+		file = open(filepath.c_str(), O_RDONLY);
+		if (file < 0) return false;
+
+		struct stat info;
+		if (fstat(file, &info) == 0 && info.st_size > 0) {
+			dataSize = (std::size_t)info.st_size;
+
+			int protection = copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+			void* mapped = mmap(nullptr, dataSize, protection, MAP_PRIVATE, file, 0);
+			if (mapped != MAP_FAILED) data = static_cast<uint8_t*>(mapped);
+		}
+#endif
+
+		if (!data) {
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Close() {
+#ifdef _WIN32
+		if (data) UnmapViewOfFile(data);
+		if (mapping) CloseHandle(mapping);
+		if (file) CloseHandle(file);
+		file = mapping = nullptr;
+#else
+		if (data) munmap(data, dataSize);
+		if (file >= 0) close(file);
+		file = -1;
+#endif
+		data = nullptr;
+		dataSize = 0;
+	}
+
+	inline bool IsOpen() const { return data != nullptr; }
+	inline bool IsCopyOnWrite() const { return isCopyOnWrite; }
+
+	inline const uint8_t* GetData() const { return data; }
+	inline uint8_t* GetMutableData() { return isCopyOnWrite ? data : nullptr; }
+	inline std::size_t GetSize() const { return dataSize; }
+
+	~MappedFile() {
+		Close();
+	}
+};
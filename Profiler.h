@@ -0,0 +1,252 @@
+#pragma once
+
+// Zones are recorded in debug builds and compile to nothing when NDEBUG is set,
+// unless PROFILER_ENABLED is defined explicitly
+#ifndef PROFILER_ENABLED
+#ifdef NDEBUG
+#define PROFILER_ENABLED 0
+#else
+#define PROFILER_ENABLED 1
+#endif
+#endif
+
+#if PROFILER_ENABLED
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+class Profiler {
+public:
+	struct Zone {
+		const char* name;
+		uint64_t start, end; //Nanoseconds since the profiler was created
+		uint32_t depth;
+	};
+
+	struct Counter {
+		const char* name;
+		double value;
+	};
+
+	static constexpr uint32_t ZonesPerThread = 1 << 16;
+	static constexpr uint32_t FrameHistory = 240;
+private:
+	// Relaxed atomics compile to plain stores, and let another thread read a slot while it is rewritten
+	struct ZoneSlot {
+		std::atomic<const char*> name;
+		std::atomic<uint64_t> start, end;
+		std::atomic<uint32_t> depth;
+	};
+
+	// Ring of the most recent zones of one thread. Only the owning thread writes, publishing each zone
+	// by bumping count; readers copy a range and drop the slots the writer lapped while they copied
+	struct ThreadBuffer {
+		std::unique_ptr<ZoneSlot[]> zones;
+		std::atomic<uint64_t> count;
+		uint32_t depth;
+		uint32_t threadIndex;
+
+		ThreadBuffer(uint32_t threadIndex) : zones(new ZoneSlot[ZonesPerThread]), count(0), depth(0), threadIndex(threadIndex) {}
+
+		// Appends the zones numbered first to last that are still in the ring
+		void Copy(uint64_t first, uint64_t last, std::vector<Zone>& out) const {
+			if (last > ZonesPerThread) first = (std::max)(first, last - ZonesPerThread);
+			std::size_t begin = out.size();
+
+			for (uint64_t i = first; i < last; i++) {
+				const ZoneSlot& slot = zones[i % ZonesPerThread];
+				out.push_back({ slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed), slot.depth.load(std::memory_order_relaxed) });
+			}
+
+			// The writer may be halfway through zone number written, which reuses the slot of written - ZonesPerThread
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t written = count.load(std::memory_order_relaxed);
+			if (written + 1 > first + ZonesPerThread) {
+				std::size_t nLapped = (std::size_t)(std::min)(written + 1 - ZonesPerThread - first, last - first);
+				out.erase(out.begin() + begin, out.begin() + begin + nLapped);
+			}
+		}
+	};
+
+	std::chrono::steady_clock::time_point origin;
+	std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+	ThreadBuffer* frameThread;
+	uint64_t frameStart, lastFrameStart, lastFrameEnd;
+	uint64_t frameFirstZone, lastFrameFirstZone, lastFrameEndZone; //Zone numbers in the frame thread's ring
+	float frameTimes[FrameHistory]; //Milliseconds
+	uint32_t frameCount;
+	std::vector<Counter> counters; //Only touched by the frame thread
+
+	Profiler() : origin(std::chrono::steady_clock::now()) {
+		frameThread = nullptr;
+		frameStart = lastFrameStart = lastFrameEnd = 0;
+		frameFirstZone = lastFrameFirstZone = lastFrameEndZone = 0;
+		frameCount = 0;
+	}
+
+	ThreadBuffer& GetThreadBuffer() {
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (!buffer) {
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffers.push_back(std::make_unique<ThreadBuffer>((uint32_t)buffers.size()));
+			buffer = buffers.back().get();
+		}
+		return *buffer;
+	}
+public:
+	static Profiler& Get() {
+		static Profiler profiler;
+		return profiler;
+	}
+
+	inline uint64_t Now() const {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+	uint32_t BeginZone() {
+		return GetThreadBuffer().depth++;
+	}
+
+	void EndZone(const char* name, uint64_t start, uint32_t depth) {
+		uint64_t end = Now();
+		ThreadBuffer& buffer = GetThreadBuffer();
+		buffer.depth = depth;
+
+		uint64_t n = buffer.count.load(std::memory_order_relaxed);
+		ZoneSlot& slot = buffer.zones[n % ZonesPerThread];
+		// Free on x86; a reader that sees any of the stores below then also sees count at least n
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.start.store(start, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		slot.depth.store(depth, std::memory_order_relaxed);
+		buffer.count.store(n + 1, std::memory_order_release);
+	}
+
+	// Closes the current frame on the calling thread, which becomes the thread shown in the overlay
+	void EndFrame() {
+		uint64_t now = Now();
+		ThreadBuffer& buffer = GetThreadBuffer();
+		uint64_t zoneCount = buffer.count.load(std::memory_order_relaxed);
+		if (frameThread != &buffer) frameFirstZone = zoneCount;
+		frameThread = &buffer;
+
+		if (frameStart != 0) frameTimes[frameCount++ % FrameHistory] = (now - frameStart) / 1e6f;
+		lastFrameStart = frameStart;
+		lastFrameEnd = now;
+		frameStart = now;
+
+		lastFrameFirstZone = frameFirstZone;
+		lastFrameEndZone = zoneCount;
+		frameFirstZone = zoneCount;
+	}
+
+	inline uint32_t GetFrameCount() const { return (std::min)(frameCount, FrameHistory); }
+
+	// Frame times in milliseconds, oldest first
+	void GetFrameTimes(float* out) const {
+		uint32_t n = GetFrameCount();
+		for (uint32_t i = 0; i < n; i++) {
+			out[i] = frameTimes[(frameCount - n + i) % FrameHistory];
+		}
+	}
+
+	float GetFramePercentile(float fraction) const {
+		float times[FrameHistory];
+		uint32_t n = GetFrameCount();
+		if (n == 0) return 0.0f;
+
+		GetFrameTimes(times);
+		uint32_t k = (std::min)((uint32_t)(fraction * n), n - 1);
+		std::nth_element(times, times + k, times + n);
+		return times[k];
+	}
+
+	// Keeps the latest value under the name, which must outlive the profiler (a literal). Call it from the
+	// frame thread; the overlay lists the counters under the zones
+	void SetCounter(const char* name, double value) {
+		for (auto& counter : counters) {
+			if (std::strcmp(counter.name, name) == 0) {
+				counter.value = value;
+				return;
+			}
+		}
+		counters.push_back({ name, value });
+	}
+
+	inline const std::vector<Counter>& GetCounters() const { return counters; }
+
+	// Zones the frame thread recorded during the last completed frame, in completion order.
+	// Zones that began in an earlier frame are left out
+	void GetLastFrameZones(std::vector<Zone>& out) {
+		out.clear();
+		if (!frameThread) return;
+
+		frameThread->Copy(lastFrameFirstZone, lastFrameEndZone, out);
+		out.erase(std::remove_if(out.begin(), out.end(), [this](const Zone& zone) { return zone.start < lastFrameStart; }), out.end());
+	}
+
+	// Writes every buffered zone of every thread as complete events in the Chrome trace format
+	bool ExportChromeTrace(const std::string& filepath) {
+		std::ofstream writer(filepath);
+		if (!writer.is_open()) return false;
+
+		// Microseconds with nanosecond digits; the default six significant digits lose them after a second
+		writer << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+		bool isFirst = true;
+
+		std::vector<Zone> zones;
+		std::lock_guard<std::mutex> registryLock(registryMutex);
+		for (auto& buffer : buffers) {
+			zones.clear();
+			buffer->Copy(0, buffer->count.load(std::memory_order_acquire), zones);
+
+			for (const Zone& zone : zones) {
+				writer << (isFirst ? "\n" : ",\n") << "{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadIndex
+					<< ",\"ts\":" << zone.start / 1000.0 << ",\"dur\":" << (zone.end - zone.start) / 1000.0 << "}";
+				isFirst = false;
+			}
+		}
+
+		writer << "\n]}\n";
+		return writer.good();
+	}
+};
+
+class ProfileScope {
+private:
+	const char* name;
+	uint64_t start;
+	uint32_t depth;
+public:
+	ProfileScope(const char* name) : name(name) {
+		depth = Profiler::Get().BeginZone();
+		start = Profiler::Get().Now();
+	}
+
+	~ProfileScope() {
+		Profiler::Get().EndZone(name, start, depth);
+	}
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// name must be a string literal; it is stored by pointer and written to traces unescaped
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_END_FRAME() Profiler::Get().EndFrame()
+#define PROFILE_COUNTER(name, value) Profiler::Get().SetCounter(name, value)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+
+// SplitMix64, used to expand a seed into generator state
+inline uint64_t SplitMix64(uint64_t& state) {
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+// xoshiro256** by Blackman and Vigna. Each instance is independent, so generators can be owned
+// per state or per thread without locking. Different streams of one seed give unrelated sequences
+class Random {
+private:
+	uint64_t state[4];
+
+	static inline uint64_t Rotl(uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+public:
+	explicit Random(uint64_t seed = 0, uint64_t stream = 0) {
+		Seed(seed, stream);
+	}
+
+	void Seed(uint64_t seed, uint64_t stream = 0) {
+		uint64_t mix = seed ^ (stream * 0xD1B54A32D192ED03ull);
+		for (auto& s : state) {
+			s = SplitMix64(mix);
+		}
+	}
+
+	uint64_t Next64() {
+		uint64_t result = Rotl(state[1] * 5, 7) * 9;
+		uint64_t t = state[1] << 17;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = Rotl(state[3], 45);
+
+		return result;
+	}
+
+	inline uint32_t Next32() { return (uint32_t)(Next64() >> 32); }
+
+	// Unbiased value in [0, bound) using Lemire's multiply-and-reject
+	uint32_t Next(uint32_t bound) {
+		uint64_t m = (uint64_t)Next32() * bound;
+		uint32_t low = (uint32_t)m;
+
+		if (low < bound) {
+			uint32_t threshold = (0u - bound) % bound;
+			while (low < threshold) {
+				m = (uint64_t)Next32() * bound;
+				low = (uint32_t)m;
+			}
+		}
+
+		return (uint32_t)(m >> 32);
+	}
+
+	// Uniform value in [low, high]
+	inline int NextInt(int low, int high) {
+		return low + (int)Next((uint32_t)(high - low) + 1);
+	}
+
+	// Uniform value in [0, 1)
+	inline float NextFloat() { return (float)(Next64() >> 40) * (1.0f / 16777216.0f); }
+	inline double NextDouble() { return (double)(Next64() >> 11) * (1.0 / 9007199254740992.0); }
+
+	// Box-Muller; one of the two values is discarded to keep the generator stateless beyond its seed
+	double NextNormal(double mean, double stdDev) {
+		double u1 = 1.0 - NextDouble();
+		double u2 = NextDouble();
+		return mean + stdDev * std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+	}
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/PrimitiveType.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/Shape.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <cstddef>
+
+// Where the game and UI draw to. Everything is submitted as vertex arrays or as the few sf::Drawable
+// types the game uses, so a surface can be backed by the GPU (WindowSurface) or by the CPU
+// (SoftwareSurface.h) without the drawing code knowing which
+class RenderSurface {
+public:
+	virtual ~RenderSurface() {}
+
+	virtual sf::Vector2u GetSize() const = 0;
+	virtual void Clear(sf::Color color = sf::Color::Black) = 0;
+
+	virtual void Draw(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states = sf::RenderStates::Default) = 0;
+	virtual void Draw(const sf::Shape& shape, const sf::RenderStates& states = sf::RenderStates::Default) = 0;
+	virtual void Draw(const sf::Sprite& sprite, const sf::RenderStates& states = sf::RenderStates::Default) = 0;
+	virtual void Draw(const sf::Text& text, const sf::RenderStates& states = sf::RenderStates::Default) = 0;
+
+	// The SFML target behind the surface, for data that only lives on the GPU (vertex buffers); null on the CPU
+	virtual sf::RenderTarget* GetTarget() { return nullptr; }
+};
+
+// Forwards to an SFML render target, usually the window
+class WindowSurface : public RenderSurface {
+private:
+	sf::RenderTarget& target;
+public:
+	WindowSurface(sf::RenderTarget& target)
+		: target(target) {}
+
+	sf::Vector2u GetSize() const override { return target.getSize(); }
+	void Clear(sf::Color color = sf::Color::Black) override { target.clear(color); }
+
+	void Draw(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states = sf::RenderStates::Default) override {
+		target.draw(vertices, count, type, states);
+	}
+
+	void Draw(const sf::Shape& shape, const sf::RenderStates& states = sf::RenderStates::Default) override { target.draw(shape, states); }
+	void Draw(const sf::Sprite& sprite, const sf::RenderStates& states = sf::RenderStates::Default) override { target.draw(sprite, states); }
+	void Draw(const sf::Text& text, const sf::RenderStates& states = sf::RenderStates::Default) override { target.draw(text, states); }
+
+	sf::RenderTarget* GetTarget() override { return &target; }
+};
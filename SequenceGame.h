@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include "Random.h"
+
+// Rules of the memory game without any rendering, audio or clock: time arrives through Advance
+// and presses through Press. All state lives in fixed-size members, so stepping never allocates.
+// RandomSource must provide uint32_t Next(uint32_t bound) returning a value in [0, bound)
+template<typename RandomSource = Random>
+class SequenceGame {
+public:
+	static constexpr uint32_t MaxSequenceLength = 1024;
+	static constexpr uint32_t MaxTileCount = 65536;
+
+	enum PressResult : uint8_t {
+		Rejected = 0, //Not waiting for input
+		Correct = 1, //Matches the sequence so far
+		Completed = 2, //Last tile of the sequence, the round is won
+		Mistake = 3 //Wrong tile, the round is lost
+	};
+
+	enum Phase : uint8_t {
+		ShowSequence = 0, //Tiles of the sequence are flashed one after another
+		Input = 1, //Waiting for the player to repeat the sequence
+		Success = 2, //Sequence repeated, every tile flashes before the next round
+		Failure = 3 //Wrong sequence, every tile flashes red before the round is retried
+	};
+private:
+	RandomSource random;
+	uint16_t sequenceInput[MaxSequenceLength];
+	uint32_t nTiles, nSequences, nOutput, index, score;
+	float dt, delay;
+	Phase phase;
+
+	void GenerateInputSequence() {
+		for (uint32_t i = 0; i < nSequences; i++) {
+			sequenceInput[i] = (uint16_t)random.Next(nTiles);
+		}
+	}
+
+	// A won round keeps the sequence and appends one tile; a lost round is retried with a new sequence
+	void StartRound(bool isExtended) {
+		phase = ShowSequence;
+		index = 0;
+		nOutput = 0;
+		dt = 0.0f;
+
+		if (isExtended) sequenceInput[nSequences - 1] = (uint16_t)random.Next(nTiles);
+		else GenerateInputSequence();
+	}
+public:
+	SequenceGame(uint32_t nTiles, RandomSource random, float delay = 1.0f)
+		: random(random), nTiles(nTiles), delay(delay) {
+		Reset();
+	}
+
+	void Reset() {
+		nSequences = 1;
+		score = 0;
+		StartRound(false);
+	}
+
+	// Returns true when a new sequence was generated during this step
+	bool Advance(float frameDt) {
+		switch (phase) {
+		case ShowSequence:
+			dt += frameDt;
+			if (dt > 2 * delay) {
+				dt = 0.0f;
+				if (++index >= nSequences) {
+					index = 0;
+					phase = Input;
+				}
+			}
+			return false;
+		case Input:
+			return false;
+		case Success:
+			dt += frameDt;
+			if (dt > 2 * delay) {
+				bool isExtended = nSequences < MaxSequenceLength;
+				if (isExtended) nSequences++;
+				score++;
+				StartRound(isExtended);
+				return true;
+			}
+			return false;
+		case Failure:
+			dt += frameDt;
+			if (dt > 2 * delay) {
+				StartRound(false);
+				return true;
+			}
+			return false;
+		}
+
+		return false;
+	}
+
+	// Presses are only taken while the player is repeating the sequence. Each one is checked
+	// against the next expected tile, so a mistake ends the round on the press that made it
+	PressResult Press(uint32_t tile) {
+		if (phase != Input || tile >= nTiles) return Rejected;
+
+		if (sequenceInput[nOutput] != tile) {
+			phase = Failure;
+			dt = 0.0f;
+			return Mistake;
+		}
+
+		if (++nOutput == nSequences) {
+			phase = Success;
+			dt = 0.0f;
+			return Completed;
+		}
+
+		return Correct;
+	}
+
+	// Each flash lasts 2 * delay: off for the first half, on for the second. ahead looks that many
+	// seconds past the last Advance within the current flash, so a renderer between two steps can
+	// show a switch when it happens rather than on the next step
+	inline bool IsFlashOn(float ahead = 0.0f) const {
+		float t = dt + ahead;
+		return t >= delay && t <= 2 * delay;
+	}
+
+	// Tile that is lit while the sequence is shown, or -1
+	inline int GetLitTile(float ahead = 0.0f) const {
+		return phase == ShowSequence && IsFlashOn(ahead) ? sequenceInput[index] : -1;
+	}
+
+	inline Phase GetPhase() const { return phase; }
+	inline uint32_t GetScore() const { return score; }
+	inline uint32_t GetTileCount() const { return nTiles; }
+	inline uint32_t GetSequenceLength() const { return nSequences; }
+	inline uint32_t GetInputCount() const { return nOutput; }
+	inline const uint16_t* GetSequence() const { return sequenceInput; }
+	inline float GetDelay() const { return delay; }
+
+	inline RandomSource& GetRandom() { return random; }
+};
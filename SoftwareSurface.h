@@ -0,0 +1,579 @@
+#pragma once
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Font.hpp>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "RenderSurface.h"
+#include "Profiler.h"
+
+// SSE2 is part of every x64 target; elsewhere the scalar kernels are used. Both give the same bytes
+#ifndef SOFTWARE_SURFACE_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_SURFACE_SIMD 1
+#else
+#define SOFTWARE_SURFACE_SIMD 0
+#endif
+#endif
+
+#if SOFTWARE_SURFACE_SIMD
+#include <emmintrin.h>
+#endif
+
+// RenderSurface rasterized on the CPU into an RGBA framebuffer laid out like sf::Image, so frames can be
+// drawn and compared on machines without a GPU or a window. A pixel is covered when its centre is inside a
+// primitive, with a top-left rule so triangles sharing an edge never touch a pixel twice. Blending is SFML's
+// default alpha blend in integer arithmetic. Textures are sampled (nearest) from sf::Image copies bound with
+// BindTexture; a texture without one samples as opaque white. Only the default view is supported
+class SoftwareSurface : public RenderSurface {
+public:
+	struct ImageDiff {
+		bool isSizeEqual;
+		uint64_t nDifferent; // Pixels with a channel off by more than the tolerance
+		uint32_t maxDelta;
+	};
+private:
+	struct Sampler {
+		const uint8_t* texels; // Null when the texture has no bound image
+		int32_t width, height;
+		bool isRepeated;
+
+		inline const uint8_t* At(float u, float v) const {
+			int32_t x = (int32_t)std::floor(u), y = (int32_t)std::floor(v);
+			if (isRepeated) {
+				x = (x % width + width) % width;
+				y = (y % height + height) % height;
+			}
+			else {
+				x = (std::min)((std::max)(x, 0), width - 1);
+				y = (std::min)((std::max)(y, 0), height - 1);
+			}
+			return texels + ((std::size_t)y * width + x) * 4;
+		}
+	};
+
+	uint32_t width, height;
+	std::vector<uint32_t> pixels; // Bytes r, g, b, a per pixel, rows top to bottom
+	std::unordered_map<const sf::Texture*, const sf::Image*> textureImages;
+
+	// Scratch reused across draws
+	std::vector<sf::Vertex> transformed, shapeVertices, glyphVertices;
+	std::vector<uint8_t> spanColors;
+
+	inline uint8_t* Row(int32_t y) { return (uint8_t*)(pixels.data() + (std::size_t)y * width); }
+
+	// First pixel whose centre is at or past a coordinate, kept in a range that converts safely
+	static inline int32_t Edge(float v) { return (int32_t)std::ceil((std::min)((std::max)(v - 0.5f, -16777216.0f), 16777216.0f)); }
+
+	// Rounded x / 255 for x up to 255 * 255
+	static inline uint8_t Div255(uint32_t x) {
+		x += 128;
+		return (uint8_t)((x + (x >> 8)) >> 8);
+	}
+
+	// rgb = src * a + dst * (1 - a), alpha = a + dstAlpha * (1 - a)
+	static inline void BlendPixel(uint8_t* dst, const uint8_t* src) {
+		uint32_t a = src[3], inv = 255 - a;
+		dst[0] = Div255(src[0] * a + dst[0] * inv);
+		dst[1] = Div255(src[1] * a + dst[1] * inv);
+		dst[2] = Div255(src[2] * a + dst[2] * inv);
+		dst[3] = Div255(a * 255 + dst[3] * inv);
+	}
+
+	static inline void Modulate(uint8_t* out, const uint8_t* texel, const sf::Color& color) {
+		out[0] = Div255(texel[0] * color.r);
+		out[1] = Div255(texel[1] * color.g);
+		out[2] = Div255(texel[2] * color.b);
+		out[3] = Div255(texel[3] * color.a);
+	}
+
+#if SOFTWARE_SURFACE_SIMD
+	static inline __m128i Div255(__m128i x) {
+		x = _mm_add_epi16(x, _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+	}
+
+	// Two pixels widened to 16 bits per channel: tinted by color, then blended over dst
+	static inline __m128i ModulateBlend(__m128i texels, __m128i dst, __m128i tint) {
+		const __m128i rgbMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+		const __m128i alphaOne = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+
+		__m128i src = Div255(_mm_mullo_epi16(texels, tint));
+		__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i srcFactor = _mm_or_si128(_mm_and_si128(alpha, rgbMask), alphaOne);
+		__m128i dstFactor = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+		return Div255(_mm_add_epi16(_mm_mullo_epi16(src, srcFactor), _mm_mullo_epi16(dst, dstFactor)));
+	}
+#endif
+
+	// count pixels of one color
+	static void BlendSpan(uint8_t* dst, uint32_t count, sf::Color color) {
+		if (color.a == 0) return;
+		if (color.a == 255) {
+			uint32_t packed;
+			std::memcpy(&packed, &color, 4);
+			std::fill((uint32_t*)dst, (uint32_t*)dst + count, packed);
+			return;
+		}
+
+		const uint8_t src[4] = { color.r, color.g, color.b, color.a };
+#if SOFTWARE_SURFACE_SIMD
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i dstFactor = _mm_set1_epi16((short)(255 - color.a));
+		const short r = (short)(color.r * color.a), g = (short)(color.g * color.a), b = (short)(color.b * color.a), a = (short)(color.a * 255);
+		const __m128i srcTerm = _mm_setr_epi16(r, g, b, a, r, g, b, a);
+
+		for (; count >= 4; count -= 4, dst += 16) {
+			__m128i pixels4 = _mm_loadu_si128((const __m128i*)dst);
+			__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels4, zero), dstFactor), srcTerm);
+			__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels4, zero), dstFactor), srcTerm);
+			_mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(Div255(lo), Div255(hi)));
+		}
+#endif
+		for (; count > 0; count--, dst += 4) BlendPixel(dst, src);
+	}
+
+	// count pixels of RGBA texels tinted by color
+	static void ModulateBlendSpan(uint8_t* dst, const uint8_t* texels, uint32_t count, sf::Color color) {
+#if SOFTWARE_SURFACE_SIMD
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i tint = _mm_setr_epi16(color.r, color.g, color.b, color.a, color.r, color.g, color.b, color.a);
+
+		for (; count >= 4; count -= 4, dst += 16, texels += 16) {
+			__m128i src4 = _mm_loadu_si128((const __m128i*)texels), dst4 = _mm_loadu_si128((const __m128i*)dst);
+			__m128i lo = ModulateBlend(_mm_unpacklo_epi8(src4, zero), _mm_unpacklo_epi8(dst4, zero), tint);
+			__m128i hi = ModulateBlend(_mm_unpackhi_epi8(src4, zero), _mm_unpackhi_epi8(dst4, zero), tint);
+			_mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+		}
+#endif
+		for (; count > 0; count--, dst += 4, texels += 4) {
+			uint8_t src[4];
+			Modulate(src, texels, color);
+			BlendPixel(dst, src);
+		}
+	}
+
+	Sampler GetSampler(const sf::Texture* texture) const {
+		Sampler sampler = { nullptr, 0, 0, false };
+		if (!texture) return sampler;
+
+		auto it = textureImages.find(texture);
+		if (it == textureImages.end() || it->second->getSize().x == 0 || it->second->getSize().y == 0) return sampler;
+
+		sampler.texels = it->second->getPixelsPtr();
+		sampler.width = (int32_t)it->second->getSize().x;
+		sampler.height = (int32_t)it->second->getSize().y;
+		sampler.isRepeated = texture->isRepeated();
+		return sampler;
+	}
+
+	// Axis-aligned quad listed clockwise from its top left corner, the order every quad builder here uses
+	static bool IsRect(const sf::Vertex* q) {
+		return q[0].position.y == q[1].position.y && q[1].position.x == q[2].position.x && q[2].position.y == q[3].position.y && q[3].position.x == q[0].position.x &&
+			q[0].position.x < q[1].position.x && q[0].position.y < q[3].position.y &&
+			q[0].texCoords.y == q[1].texCoords.y && q[1].texCoords.x == q[2].texCoords.x && q[2].texCoords.y == q[3].texCoords.y && q[3].texCoords.x == q[0].texCoords.x &&
+			q[0].color == q[1].color && q[0].color == q[2].color && q[0].color == q[3].color;
+	}
+
+	// Covers the same pixels as the quad's two triangles would, a row at a time
+	void FillRect(const sf::Vertex* q, const Sampler& sampler) {
+		float left = q[0].position.x, top = q[0].position.y, right = q[2].position.x, bottom = q[2].position.y;
+		int32_t x0 = (std::max)(Edge(left), 0), x1 = (std::min)(Edge(right), (int32_t)width);
+		int32_t y0 = (std::max)(Edge(top), 0), y1 = (std::min)(Edge(bottom), (int32_t)height);
+		if (x0 >= x1 || y0 >= y1) return;
+
+		sf::Color color = q[0].color;
+		uint32_t count = (uint32_t)(x1 - x0);
+		if (!sampler.texels) {
+			for (int32_t y = y0; y < y1; y++) BlendSpan(Row(y) + x0 * 4, count, color);
+			return;
+		}
+
+		float u0 = q[0].texCoords.x, v0 = q[0].texCoords.y;
+		float du = (q[2].texCoords.x - u0) / (right - left), dv = (q[2].texCoords.y - v0) / (bottom - top);
+		float uFirst = u0 + (x0 + 0.5f - left) * du;
+		int32_t texelFirst = (int32_t)std::floor(uFirst);
+
+		// Texels drawn one to one are read straight from the image row
+		bool isDirect = du == 1.0f && !sampler.isRepeated && texelFirst >= 0 && texelFirst + (int32_t)count <= sampler.width;
+		spanColors.resize((std::size_t)count * 4);
+
+		for (int32_t y = y0; y < y1; y++) {
+			float v = v0 + (y + 0.5f - top) * dv;
+			const uint8_t* texels = sampler.At((float)texelFirst, v);
+
+			if (!isDirect) {
+				for (uint32_t i = 0; i < count; i++) std::memcpy(&spanColors[i * 4], sampler.At(u0 + (x0 + i + 0.5f - left) * du, v), 4);
+				texels = spanColors.data();
+			}
+
+			ModulateBlendSpan(Row(y) + x0 * 4, texels, count, color);
+		}
+	}
+
+	// x where the edge from top to bottom crosses y. Every triangle computes a shared edge through this one
+	// expression with the same endpoint order, so neighbours agree on it exactly
+	static inline float EdgeX(const sf::Vector2f& top, const sf::Vector2f& bottom, float y) {
+		return top.x + (y - top.y) * (bottom.x - top.x) / (bottom.y - top.y);
+	}
+
+	static inline bool IsAbove(const sf::Vector2f& a, const sf::Vector2f& b) {
+		return a.y < b.y || (a.y == b.y && a.x < b.x);
+	}
+
+	void FillTriangle(const sf::Vertex& v0, const sf::Vertex& v1, const sf::Vertex& v2, const Sampler& sampler) {
+		const sf::Vector2f p0 = v0.position, p1 = v1.position, p2 = v2.position;
+		float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+		if (area == 0.0f || !std::isfinite(area)) return;
+
+		const sf::Vector2f* a = &p0, * b = &p1, * c = &p2;
+		if (IsAbove(*b, *a)) std::swap(a, b);
+		if (IsAbove(*c, *b)) std::swap(b, c);
+		if (IsAbove(*b, *a)) std::swap(a, b);
+
+		int32_t y0 = (std::max)(Edge(a->y), 0), y1 = (std::min)(Edge(c->y), (int32_t)height);
+		bool isFlat = !sampler.texels && v0.color == v1.color && v0.color == v2.color;
+
+		// Barycentric weights of v1 and v2 step linearly across a row
+		float w1dx = (p2.y - p0.y) / area, w1dy = (p0.x - p2.x) / area;
+		float w2dx = (p0.y - p1.y) / area, w2dy = (p1.x - p0.x) / area;
+
+		for (int32_t y = y0; y < y1; y++) {
+			float yc = y + 0.5f;
+			float xLong = EdgeX(*a, *c, yc);
+			float xShort = yc < b->y ? EdgeX(*a, *b, yc) : EdgeX(*b, *c, yc);
+
+			int32_t x0 = (std::max)(Edge((std::min)(xLong, xShort)), 0), x1 = (std::min)(Edge((std::max)(xLong, xShort)), (int32_t)width);
+			if (x0 >= x1) continue;
+
+			uint32_t count = (uint32_t)(x1 - x0);
+			if (isFlat) {
+				BlendSpan(Row(y) + x0 * 4, count, v0.color);
+				continue;
+			}
+
+			float w1 = (x0 + 0.5f - p0.x) * w1dx + (yc - p0.y) * w1dy;
+			float w2 = (x0 + 0.5f - p0.x) * w2dx + (yc - p0.y) * w2dy;
+
+			spanColors.resize((std::size_t)count * 4);
+			for (uint32_t i = 0; i < count; i++, w1 += w1dx, w2 += w2dx) {
+				float w0 = 1.0f - w1 - w2;
+				sf::Color color(
+					(uint8_t)(std::min)((std::max)(w0 * v0.color.r + w1 * v1.color.r + w2 * v2.color.r + 0.5f, 0.0f), 255.0f),
+					(uint8_t)(std::min)((std::max)(w0 * v0.color.g + w1 * v1.color.g + w2 * v2.color.g + 0.5f, 0.0f), 255.0f),
+					(uint8_t)(std::min)((std::max)(w0 * v0.color.b + w1 * v1.color.b + w2 * v2.color.b + 0.5f, 0.0f), 255.0f),
+					(uint8_t)(std::min)((std::max)(w0 * v0.color.a + w1 * v1.color.a + w2 * v2.color.a + 0.5f, 0.0f), 255.0f));
+
+				uint8_t* out = &spanColors[i * 4];
+				if (sampler.texels) {
+					Modulate(out, sampler.At(w0 * v0.texCoords.x + w1 * v1.texCoords.x + w2 * v2.texCoords.x, w0 * v0.texCoords.y + w1 * v1.texCoords.y + w2 * v2.texCoords.y), color);
+				}
+				else {
+					out[0] = color.r;
+					out[1] = color.g;
+					out[2] = color.b;
+					out[3] = color.a;
+				}
+			}
+
+			ModulateBlendSpan(Row(y) + x0 * 4, spanColors.data(), count, sf::Color::White);
+		}
+	}
+
+	// One pixel per step along the major axis, at the pixel centres between the ends, the last one excluded
+	void DrawLineSegment(const sf::Vertex& from, const sf::Vertex& to) {
+		float dx = to.position.x - from.position.x, dy = to.position.y - from.position.y;
+		bool isXMajor = std::fabs(dx) >= std::fabs(dy);
+		float length = isXMajor ? dx : dy;
+		if (length == 0.0f) return;
+
+		float start = isXMajor ? from.position.x : from.position.y;
+		int32_t first = Edge((std::min)(start, start + length)), last = Edge((std::max)(start, start + length));
+		int32_t limit = (int32_t)(isXMajor ? width : height);
+		first = (std::max)(first, 0);
+		last = (std::min)(last, limit);
+
+		for (int32_t i = first; i < last; i++) {
+			float t = (i + 0.5f - start) / length;
+			float minor = isXMajor ? from.position.y + t * dy : from.position.x + t * dx;
+			int32_t x = isXMajor ? i : (int32_t)std::floor(minor), y = isXMajor ? (int32_t)std::floor(minor) : i;
+			if (x < 0 || y < 0 || x >= (int32_t)width || y >= (int32_t)height) continue;
+
+			uint8_t src[4] = { from.color.r, from.color.g, from.color.b, from.color.a };
+			if (from.color != to.color) {
+				src[0] = (uint8_t)(from.color.r + (to.color.r - from.color.r) * t + 0.5f);
+				src[1] = (uint8_t)(from.color.g + (to.color.g - from.color.g) * t + 0.5f);
+				src[2] = (uint8_t)(from.color.b + (to.color.b - from.color.b) * t + 0.5f);
+				src[3] = (uint8_t)(from.color.a + (to.color.a - from.color.a) * t + 0.5f);
+			}
+			BlendPixel(Row(y) + x * 4, src);
+		}
+	}
+
+	void DrawPoint(const sf::Vertex& point) {
+		int32_t x = (int32_t)std::floor(point.position.x), y = (int32_t)std::floor(point.position.y);
+		if (x < 0 || y < 0 || x >= (int32_t)width || y >= (int32_t)height) return;
+
+		const uint8_t src[4] = { point.color.r, point.color.g, point.color.b, point.color.a };
+		BlendPixel(Row(y) + x * 4, src);
+	}
+public:
+	SoftwareSurface(uint32_t width = 0, uint32_t height = 0) {
+		Resize(width, height);
+	}
+
+	void Resize(uint32_t newWidth, uint32_t newHeight) {
+		width = newWidth;
+		height = newHeight;
+		pixels.assign((std::size_t)width * height, 0);
+	}
+
+	// The image must outlive the binding; rebind after the texture's contents change
+	void BindTexture(const sf::Texture& texture, const sf::Image& image) {
+		textureImages[&texture] = &image;
+	}
+
+	void UnbindTexture(const sf::Texture& texture) {
+		textureImages.erase(&texture);
+	}
+
+	sf::Vector2u GetSize() const override { return { width, height }; }
+
+	void Clear(sf::Color color = sf::Color::Black) override {
+		uint32_t packed;
+		std::memcpy(&packed, &color, 4);
+		std::fill(pixels.begin(), pixels.end(), packed);
+	}
+
+	void Draw(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states = sf::RenderStates::Default) override {
+		PROFILE_ZONE("SoftwareSurface::Draw");
+
+		transformed.resize(count);
+		for (std::size_t i = 0; i < count; i++) {
+			transformed[i] = vertices[i];
+			transformed[i].position = states.transform.transformPoint(vertices[i].position);
+		}
+
+		const sf::Vertex* v = transformed.data();
+		Sampler sampler = GetSampler(states.texture);
+
+		switch (type) {
+		case sf::Points:
+			for (std::size_t i = 0; i < count; i++) DrawPoint(v[i]);
+			break;
+		case sf::Lines:
+			for (std::size_t i = 1; i < count; i += 2) DrawLineSegment(v[i - 1], v[i]);
+			break;
+		case sf::LineStrip:
+			for (std::size_t i = 1; i < count; i++) DrawLineSegment(v[i - 1], v[i]);
+			break;
+		case sf::Triangles:
+			for (std::size_t i = 2; i < count; i += 3) FillTriangle(v[i - 2], v[i - 1], v[i], sampler);
+			break;
+		case sf::TriangleStrip:
+			for (std::size_t i = 2; i < count; i++) FillTriangle(v[i - 2], v[i - 1], v[i], sampler);
+			break;
+		case sf::TriangleFan:
+			for (std::size_t i = 2; i < count; i++) FillTriangle(v[0], v[i - 1], v[i], sampler);
+			break;
+		case sf::Quads:
+			for (std::size_t i = 3; i < count; i += 4) {
+				const sf::Vertex* q = v + i - 3;
+				if (IsRect(q)) {
+					FillRect(q, sampler);
+				}
+				else {
+					FillTriangle(q[0], q[1], q[2], sampler);
+					FillTriangle(q[0], q[2], q[3], sampler);
+				}
+			}
+			break;
+		}
+	}
+
+	// The fill as a fan around the centre of the points and the outline as a strip along the averaged
+	// edge normals, as sf::Shape builds them; four-point shapes go through the quad path
+	void Draw(const sf::Shape& shape, const sf::RenderStates& states = sf::RenderStates::Default) override {
+		std::size_t nPoints = shape.getPointCount();
+		if (nPoints < 3) return;
+
+		sf::RenderStates shapeStates = states;
+		shapeStates.transform *= shape.getTransform();
+		shapeStates.texture = shape.getTexture();
+
+		sf::Vector2f low = shape.getPoint(0), high = low;
+		for (std::size_t i = 1; i < nPoints; i++) {
+			sf::Vector2f p = shape.getPoint(i);
+			low = { (std::min)(low.x, p.x), (std::min)(low.y, p.y) };
+			high = { (std::max)(high.x, p.x), (std::max)(high.y, p.y) };
+		}
+		sf::Vector2f center((low.x + high.x) / 2.0f, (low.y + high.y) / 2.0f);
+
+		sf::IntRect textureRect = shape.getTextureRect();
+		auto TexCoords = [&](const sf::Vector2f& p) {
+			float u = high.x > low.x ? (p.x - low.x) / (high.x - low.x) : 0.0f, v = high.y > low.y ? (p.y - low.y) / (high.y - low.y) : 0.0f;
+			return sf::Vector2f(textureRect.left + textureRect.width * u, textureRect.top + textureRect.height * v);
+		};
+
+		shapeVertices.clear();
+		if (nPoints == 4) {
+			for (std::size_t i = 0; i < 4; i++) shapeVertices.emplace_back(shape.getPoint(i), shape.getFillColor(), TexCoords(shape.getPoint(i)));
+			Draw(shapeVertices.data(), 4, sf::Quads, shapeStates);
+		}
+		else {
+			shapeVertices.emplace_back(center, shape.getFillColor(), TexCoords(center));
+			for (std::size_t i = 0; i <= nPoints; i++) shapeVertices.emplace_back(shape.getPoint(i % nPoints), shape.getFillColor(), TexCoords(shape.getPoint(i % nPoints)));
+			Draw(shapeVertices.data(), shapeVertices.size(), sf::TriangleFan, shapeStates);
+		}
+
+		float thickness = shape.getOutlineThickness();
+		if (thickness == 0.0f) return;
+
+		auto Normal = [](const sf::Vector2f& p1, const sf::Vector2f& p2) {
+			sf::Vector2f n(p1.y - p2.y, p2.x - p1.x);
+			float length = std::sqrt(n.x * n.x + n.y * n.y);
+			return length != 0.0f ? sf::Vector2f(n.x / length, n.y / length) : n;
+		};
+
+		shapeVertices.clear();
+		for (std::size_t i = 0; i <= nPoints; i++) {
+			std::size_t index = i % nPoints;
+			sf::Vector2f p0 = shape.getPoint(index == 0 ? nPoints - 1 : index - 1), p1 = shape.getPoint(index), p2 = shape.getPoint((index + 1) % nPoints);
+
+			sf::Vector2f n1 = Normal(p0, p1), n2 = Normal(p1, p2);
+			if (n1.x * (center.x - p1.x) + n1.y * (center.y - p1.y) > 0.0f) n1 = { -n1.x, -n1.y };
+			if (n2.x * (center.x - p1.x) + n2.y * (center.y - p1.y) > 0.0f) n2 = { -n2.x, -n2.y };
+
+			float factor = 1.0f + (n1.x * n2.x + n1.y * n2.y);
+			sf::Vector2f normal((n1.x + n2.x) / factor, (n1.y + n2.y) / factor);
+
+			shapeVertices.emplace_back(p1, shape.getOutlineColor());
+			shapeVertices.emplace_back(sf::Vector2f(p1.x + normal.x * thickness, p1.y + normal.y * thickness), shape.getOutlineColor());
+		}
+
+		shapeStates.texture = nullptr;
+		Draw(shapeVertices.data(), shapeVertices.size(), sf::TriangleStrip, shapeStates);
+	}
+
+	void Draw(const sf::Sprite& sprite, const sf::RenderStates& states = sf::RenderStates::Default) override {
+		sf::IntRect rect = sprite.getTextureRect();
+		float w = (float)std::abs(rect.width), h = (float)std::abs(rect.height);
+		float u1 = (float)rect.left, v1 = (float)rect.top, u2 = u1 + rect.width, v2 = v1 + rect.height;
+
+		const sf::Vertex quad[4] = {
+			sf::Vertex({ 0.0f, 0.0f }, sprite.getColor(), { u1, v1 }),
+			sf::Vertex({ w, 0.0f }, sprite.getColor(), { u2, v1 }),
+			sf::Vertex({ w, h }, sprite.getColor(), { u2, v2 }),
+			sf::Vertex({ 0.0f, h }, sprite.getColor(), { u1, v2 })
+		};
+
+		sf::RenderStates spriteStates = states;
+		spriteStates.transform *= sprite.getTransform();
+		spriteStates.texture = sprite.getTexture();
+		Draw(quad, 4, sf::Quads, spriteStates);
+	}
+
+	// Glyph quads laid out as sf::Text lays them out, without the underline, strike-through and outline styles
+	void Draw(const sf::Text& text, const sf::RenderStates& states = sf::RenderStates::Default) override {
+		const sf::Font* font = text.getFont();
+		if (!font) return;
+
+		uint32_t characterSize = text.getCharacterSize();
+		bool isBold = (text.getStyle() & sf::Text::Bold) != 0;
+		float whitespaceWidth = font->getGlyph(' ', characterSize, isBold).advance;
+		float letterSpacing = (whitespaceWidth / 3.0f) * (text.getLetterSpacing() - 1.0f);
+		whitespaceWidth += letterSpacing;
+		float lineSpacing = font->getLineSpacing(characterSize) * text.getLineSpacing();
+
+		const sf::String& str = text.getString();
+		sf::Color color = text.getFillColor();
+		float x = 0.0f, y = (float)characterSize;
+		sf::Uint32 previous = 0;
+
+		glyphVertices.clear();
+		for (std::size_t i = 0; i < str.getSize(); i++) {
+			sf::Uint32 c = str[i];
+			if (c == '\r') continue;
+
+			x += font->getKerning(previous, c, characterSize);
+			previous = c;
+
+			if (c == ' ' || c == '\t' || c == '\n') {
+				if (c == ' ') x += whitespaceWidth;
+				else if (c == '\t') x += whitespaceWidth * 4;
+				else {
+					x = 0.0f;
+					y += lineSpacing;
+				}
+				continue;
+			}
+
+			const sf::Glyph& glyph = font->getGlyph(c, characterSize, isBold);
+			float left = x + glyph.bounds.left, top = y + glyph.bounds.top;
+			float right = left + glyph.bounds.width, bottom = top + glyph.bounds.height;
+			float u1 = (float)glyph.textureRect.left, v1 = (float)glyph.textureRect.top;
+			float u2 = u1 + glyph.textureRect.width, v2 = v1 + glyph.textureRect.height;
+
+			glyphVertices.emplace_back(sf::Vector2f(left, top), color, sf::Vector2f(u1, v1));
+			glyphVertices.emplace_back(sf::Vector2f(right, top), color, sf::Vector2f(u2, v1));
+			glyphVertices.emplace_back(sf::Vector2f(right, bottom), color, sf::Vector2f(u2, v2));
+			glyphVertices.emplace_back(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2));
+
+			x += glyph.advance + letterSpacing;
+		}
+
+		sf::RenderStates textStates = states;
+		textStates.transform *= text.getTransform();
+		textStates.texture = &font->getTexture(characterSize);
+		Draw(glyphVertices.data(), glyphVertices.size(), sf::Quads, textStates);
+	}
+
+	inline const uint8_t* GetPixels() const { return (const uint8_t*)pixels.data(); }
+
+	sf::Image GetImage() const {
+		sf::Image image;
+		image.create(width, height, GetPixels());
+		return image;
+	}
+
+	bool SaveToFile(const std::string& filepath) const {
+		return GetImage().saveToFile(filepath);
+	}
+
+	// Per-channel comparison with a golden image. The diff image, when given, shows matching pixels
+	// dimmed and differing ones in red
+	ImageDiff Compare(const sf::Image& golden, uint8_t tolerance = 0, sf::Image* diff = nullptr) const {
+		ImageDiff result = { golden.getSize().x == width && golden.getSize().y == height, 0, 0 };
+		if (!result.isSizeEqual) return result;
+
+		const uint8_t* a = GetPixels();
+		const uint8_t* b = golden.getPixelsPtr();
+		std::vector<uint8_t> diffPixels(diff ? (std::size_t)width * height * 4 : 0);
+
+		for (std::size_t i = 0; i < (std::size_t)width * height; i++) {
+			uint32_t delta = 0;
+			for (int k = 0; k < 4; k++) delta = (std::max)(delta, (uint32_t)std::abs(a[i * 4 + k] - b[i * 4 + k]));
+
+			result.maxDelta = (std::max)(result.maxDelta, delta);
+			if (delta > tolerance) result.nDifferent++;
+
+			if (diff) {
+				uint8_t* out = &diffPixels[i * 4];
+				uint8_t grey = (uint8_t)((a[i * 4] + a[i * 4 + 1] + a[i * 4 + 2]) / 12);
+				out[0] = delta > tolerance ? 255 : grey;
+				out[1] = delta > tolerance ? 0 : grey;
+				out[2] = delta > tolerance ? 0 : grey;
+				out[3] = 255;
+			}
+		}
+
+		if (diff) diff->create(width, height, diffPixels.data());
+		return result;
+	}
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <atomic>
+
+class ThreadPool {
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool isStopping;
+
+	void WorkerLoop() {
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return isStopping || !tasks.empty(); });
+
+				if (isStopping && tasks.empty()) return;
+
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+public:
+	explicit ThreadPool(uint32_t nThreads = (std::max)(1u, std::thread::hardware_concurrency())) {
+		isStopping = false;
+		for (uint32_t i = 0; i < nThreads; i++) {
+			workers.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	template<typename Function>
+	auto Submit(Function&& function) -> std::future<decltype(function())> {
+		using Result = decltype(function());
+
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+		std::future<Result> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.emplace_back([task] { (*task)(); });
+		}
+		condition.notify_one();
+
+		return result;
+	}
+
+	// Runs function(begin, end, slot) over [0, count) on every worker and waits for it. Each slot owns one
+	// contiguous share of the range and takes grain-sized chunks from it; a slot whose share is used up
+	// steals chunks from the others. Slots never run concurrently with themselves, so per-slot buffers
+	// need no locking. Must not be called from inside a pool task
+	template<typename Function>
+	void ParallelFor(std::size_t count, std::size_t grain, Function function) {
+		struct alignas(64) Range {
+			std::atomic<std::size_t> next;
+			std::size_t end;
+		};
+
+		uint32_t nSlots = GetThreadCount();
+		grain = (std::max<std::size_t>)(grain, 1);
+
+		std::unique_ptr<Range[]> ranges(new Range[nSlots]);
+		for (uint32_t i = 0; i < nSlots; i++) {
+			ranges[i].next.store(count * i / nSlots, std::memory_order_relaxed);
+			ranges[i].end = count * (i + 1) / nSlots;
+		}
+
+		std::vector<std::future<void>> results;
+		for (uint32_t slot = 0; slot < nSlots; slot++) {
+			results.push_back(Submit([&ranges, &function, nSlots, grain, slot] {
+				for (uint32_t k = 0; k < nSlots; k++) {
+					Range& range = ranges[(slot + k) % nSlots];
+
+					while (true) {
+						std::size_t begin = range.next.fetch_add(grain, std::memory_order_relaxed);
+						if (begin >= range.end) break;
+
+						function(begin, (std::min)(begin + grain, range.end), slot);
+					}
+				}
+			}));
+		}
+
+		for (auto& result : results) {
+			result.get();
+		}
+	}
+
+	inline uint32_t GetThreadCount() const { return (uint32_t)workers.size(); }
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			isStopping = true;
+		}
+		condition.notify_all();
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+};
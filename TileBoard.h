@@ -0,0 +1,202 @@
+#pragma once
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/PrimitiveType.hpp>
+#include <SFML/Window/Event.hpp>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "Profiler.h"
+#include "RenderSurface.h"
+
+// Board of columns x rows square tiles centred in an area. Tile data is kept as parallel arrays, all
+// tiles are one quad array drawn with a single call, and a mouse position maps to a tile arithmetically.
+// Colours are written into the quads only when a tile's fill actually changes
+class TileBoard {
+public:
+	enum TileState : uint8_t {
+		MousePressed = 0,
+		MouseHover = 1,
+		MouseRelease = 2
+	};
+
+	static constexpr uint32_t MaxColumns = 64, MaxRows = 64;
+private:
+	uint32_t columns, rows;
+	float originX, originY, tileSize, pitch;
+
+	// Per tile, indexed by row * columns + column
+	std::vector<float> xs, ys;
+	std::vector<sf::Color> pressedColors, hoverColors, releaseColors;
+	std::vector<sf::Color> fills;
+	std::vector<uint8_t> states;
+
+	std::vector<sf::Vertex> vertices;
+	int32_t hovered, pressed;
+
+	void WriteFill(uint32_t tile, sf::Color color) {
+		if (fills[tile] == color) return;
+
+		fills[tile] = color;
+		sf::Vertex* quad = &vertices[(std::size_t)tile * 4];
+		quad[0].color = color;
+		quad[1].color = color;
+		quad[2].color = color;
+		quad[3].color = color;
+	}
+
+	sf::Color StateColor(uint32_t tile) const {
+		switch (states[tile]) {
+		case MousePressed: return pressedColors[tile];
+		case MouseHover: return hoverColors[tile];
+		default: return releaseColors[tile];
+		}
+	}
+
+	void SetState(int32_t tile, TileState state) {
+		if (tile < 0) return;
+
+		states[tile] = state;
+		WriteFill((uint32_t)tile, StateColor((uint32_t)tile));
+	}
+public:
+	TileBoard(uint32_t nColumns, uint32_t nRows, const sf::FloatRect& area, float gapFraction = 15.0f / 220.0f) {
+		columns = (std::min)((std::max)(nColumns, 1u), MaxColumns);
+		rows = (std::min)((std::max)(nRows, 1u), MaxRows);
+
+		// Gap of gapFraction of a tile, at least a pixel, between tiles and around the board
+		float fitPitch = (std::min)(area.width / (columns + gapFraction), area.height / (rows + gapFraction));
+		float gap = (std::max)(1.0f, std::round(fitPitch * gapFraction / (1.0f + gapFraction)));
+		pitch = std::floor(fitPitch);
+		tileSize = (std::max)(1.0f, pitch - gap);
+		originX = std::floor(area.left + (area.width - columns * pitch + (pitch - tileSize)) / 2.0f);
+		originY = std::floor(area.top + (area.height - rows * pitch + (pitch - tileSize)) / 2.0f);
+
+		uint32_t nTiles = columns * rows;
+		xs.resize(nTiles);
+		ys.resize(nTiles);
+		pressedColors.resize(nTiles);
+		hoverColors.resize(nTiles);
+		releaseColors.resize(nTiles);
+		fills.assign(nTiles, sf::Color::Transparent);
+		states.assign(nTiles, MouseRelease);
+		vertices.resize((std::size_t)nTiles * 4);
+
+		for (uint32_t tile = 0; tile < nTiles; tile++) {
+			xs[tile] = originX + (tile % columns) * pitch;
+			ys[tile] = originY + (tile / columns) * pitch;
+
+			sf::Vertex* quad = &vertices[(std::size_t)tile * 4];
+			quad[0] = sf::Vertex({ xs[tile], ys[tile] }, sf::Color::Transparent);
+			quad[1] = sf::Vertex({ xs[tile] + tileSize, ys[tile] }, sf::Color::Transparent);
+			quad[2] = sf::Vertex({ xs[tile] + tileSize, ys[tile] + tileSize }, sf::Color::Transparent);
+			quad[3] = sf::Vertex({ xs[tile], ys[tile] + tileSize }, sf::Color::Transparent);
+		}
+
+		hovered = -1;
+		pressed = -1;
+	}
+
+	// Tile under the position, or -1 over the gaps and outside the board
+	int32_t HitTest(const sf::Vector2f& position) const {
+		float x = position.x - originX, y = position.y - originY;
+		if (x < 0.0f || y < 0.0f) return -1;
+
+		uint32_t column = (uint32_t)(x / pitch), row = (uint32_t)(y / pitch);
+		if (column >= columns || row >= rows || x - column * pitch >= tileSize || y - row * pitch >= tileSize) return -1;
+
+		return (int32_t)(row * columns + column);
+	}
+
+	void SetColors(uint32_t tile, const sf::Color& onPress, const sf::Color& onHover, const sf::Color& onRelease) {
+		pressedColors[tile] = onPress;
+		hoverColors[tile] = onHover;
+		releaseColors[tile] = onRelease;
+	}
+
+	// Overrides the fill until the tile's state changes or ResetColors is called
+	void SetFillColor(uint32_t tile, const sf::Color& color) {
+		WriteFill(tile, color);
+	}
+
+	void SetAllFillColors(TileState state) {
+		for (uint32_t tile = 0; tile < (uint32_t)fills.size(); tile++) {
+			WriteFill(tile, state == MousePressed ? pressedColors[tile] : state == MouseHover ? hoverColors[tile] : releaseColors[tile]);
+		}
+	}
+
+	void SetAllFillColors(const sf::Color& color) {
+		for (uint32_t tile = 0; tile < (uint32_t)fills.size(); tile++) WriteFill(tile, color);
+	}
+
+	// Drops hover and press and shows every tile in its release colour
+	void ResetColors() {
+		hovered = -1;
+		pressed = -1;
+		states.assign(states.size(), MouseRelease);
+		SetAllFillColors(MouseRelease);
+	}
+
+	// Hover and press tracking for the board as a whole. Returns the tile a left press landed on, or -1
+	int32_t ManageEvent(const sf::Event& e, const sf::Vector2f& mousePos) {
+		switch (e.type) {
+		case sf::Event::MouseMoved: {
+			if (pressed >= 0) break;
+
+			int32_t tile = HitTest(mousePos);
+			if (tile != hovered) {
+				SetState(hovered, MouseRelease);
+				SetState(tile, MouseHover);
+				hovered = tile;
+			}
+			break;
+		}
+		case sf::Event::MouseButtonPressed: {
+			if (e.mouseButton.button != sf::Mouse::Left) break;
+
+			int32_t tile = HitTest(mousePos);
+			if (tile < 0) break;
+
+			if (hovered != tile) SetState(hovered, MouseRelease);
+			SetState(tile, MousePressed);
+			pressed = tile;
+			hovered = tile;
+			return tile;
+		}
+		case sf::Event::MouseButtonReleased: {
+			if (e.mouseButton.button != sf::Mouse::Left || pressed < 0) break;
+
+			int32_t tile = HitTest(mousePos);
+			SetState(pressed, tile == pressed ? MouseHover : MouseRelease);
+			if (tile != pressed) SetState(tile, MouseHover);
+			hovered = tile;
+			pressed = -1;
+			break;
+		}
+		case sf::Event::MouseLeft:
+			if (pressed < 0) {
+				SetState(hovered, MouseRelease);
+				hovered = -1;
+			}
+			break;
+		default:
+			break;
+		}
+
+		return -1;
+	}
+
+	void Render(RenderSurface& surface) const {
+		PROFILE_ZONE("TileBoard::Render");
+		surface.Draw(vertices.data(), vertices.size(), sf::Quads);
+	}
+
+	inline uint32_t GetColumns() const { return columns; }
+	inline uint32_t GetRows() const { return rows; }
+	inline uint32_t GetTileCount() const { return columns * rows; }
+	inline float GetTileSize() const { return tileSize; }
+	inline sf::Color const* GetColors(TileState state) const {
+		return state == MousePressed ? pressedColors.data() : state == MouseHover ? hoverColors.data() : releaseColors.data();
+	}
+};
@@ -0,0 +1,222 @@
+#pragma once
+#include <SFML/Audio/SoundBuffer.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <future>
+#include "ThreadPool.h"
+#include "MappedFile.h"
+
+struct ToneParams {
+	uint32_t nTones;
+	uint32_t sampleRate;
+	float duration; // Seconds
+	float baseFrequency; // Hz of tone 0
+	float attack, release; // Seconds of the linear fade in and out
+	float volume; // 0 to 1
+};
+
+struct ToneBankHeader {
+	char magic[4];
+	uint32_t version;
+	ToneParams params;
+	uint32_t nSamplesPerTone;
+};
+
+static const char ToneBankMagic[4] = { 'T', 'C', 'T', 'B' };
+
+// One sf::SoundBuffer per tile, synthesized instead of loaded from WAV files. Tile i is step i of a major
+// pentatonic scale over baseFrequency, so neighbouring tiles stay distinct for any tile count. Banks are
+// cached under cacheDirectory keyed by a hash of their parameters
+class ToneBank {
+private:
+	static const uint32_t Version = 1;
+	static const uint32_t BlockSize = 4096; // Samples per work item
+
+	ToneParams params;
+	uint32_t nSamplesPerTone;
+	std::vector<sf::SoundBuffer> buffers;
+
+	// Synthesis started by GenerateAsync and finished by Wait
+	std::vector<int16_t> samples;
+	std::vector<std::future<void>> pending;
+	std::string cachePath;
+	bool isGenerating;
+
+	// sin(2 pi cycles) for cycles >= 0: a parabola through the zeros and peaks of each half period,
+	// refined by a second parabola (max error about 0.001). No branches or calls, so the loop below vectorizes
+	static inline float SinCycles(float cycles) {
+		float y = cycles - (float)(int32_t)cycles - 0.5f;
+		float q = 8.0f * y - 16.0f * y * std::fabs(y);
+		q = 0.225f * (q * std::fabs(q) - q) + q;
+		return -q;
+	}
+
+	// Samples [begin, end) of one tone: a sine and a quieter third harmonic under the attack/release envelope
+	static void Synthesize(float frequency, const ToneParams& params, uint32_t nSamples, uint32_t begin, uint32_t end, int16_t* out) {
+		const float cyclesPerSample = frequency / params.sampleRate;
+		const float attackSamples = (std::max)(1.0f, params.attack * params.sampleRate);
+		const float releaseSamples = (std::max)(1.0f, params.release * params.sampleRate);
+		const float scale = params.volume * 32767.0f / 1.25f;
+
+		for (uint32_t i = begin; i < end; i++) {
+			float n = (float)i;
+			float cycles = n * cyclesPerSample;
+			float sample = SinCycles(cycles) + 0.25f * SinCycles(3.0f * cycles);
+			float remaining = (float)nSamples - n;
+			float envelope = (std::min)((std::min)(n, attackSamples) / attackSamples, (std::min)(remaining, releaseSamples) / releaseSamples);
+			out[i] = (int16_t)(sample * envelope * scale);
+		}
+	}
+
+	static uint64_t HashParams(const ToneParams& params) {
+		uint8_t bytes[sizeof(ToneParams) + sizeof(uint32_t)];
+		std::memcpy(bytes, &params, sizeof(ToneParams));
+		uint32_t version = Version;
+		std::memcpy(bytes + sizeof(ToneParams), &version, sizeof(uint32_t));
+
+		uint64_t hash = 14695981039346656037ull;
+		for (uint8_t byte : bytes) {
+			hash = (hash ^ byte) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool LoadFromSamples(const int16_t* samples) {
+		buffers.resize(params.nTones);
+		for (uint32_t i = 0; i < params.nTones; i++) {
+			if (!buffers[i].loadFromSamples(samples + (std::size_t)i * nSamplesPerTone, nSamplesPerTone, 1, params.sampleRate)) {
+				buffers.clear();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool LoadCache(const std::string& filepath) {
+		MappedFile file;
+		if (!file.Open(filepath)) return false;
+
+		ToneBankHeader header;
+		if (file.GetSize() < sizeof(header)) return false;
+		std::memcpy(&header, file.GetData(), sizeof(header));
+
+		if (std::memcmp(header.magic, ToneBankMagic, 4) != 0 || header.version != Version || std::memcmp(&header.params, &params, sizeof(ToneParams)) != 0 ||
+			header.nSamplesPerTone != nSamplesPerTone || file.GetSize() != sizeof(header) + (std::size_t)params.nTones * nSamplesPerTone * sizeof(int16_t)) {
+			return false;
+		}
+
+		return LoadFromSamples((const int16_t*)(file.GetData() + sizeof(header)));
+	}
+
+	void SaveCache(const std::string& filepath, const std::vector<int16_t>& samples) const {
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(filepath).parent_path(), error);
+
+		std::ofstream writer(filepath, std::ios::binary);
+		if (!writer.is_open()) {
+			std::cout << "Couldn't write the tone cache " << filepath << std::endl;
+			return;
+		}
+
+		ToneBankHeader header;
+		std::memcpy(header.magic, ToneBankMagic, 4);
+		header.version = Version;
+		header.params = params;
+		header.nSamplesPerTone = nSamplesPerTone;
+
+		writer.write((const char*)&header, sizeof(header));
+		writer.write((const char*)samples.data(), samples.size() * sizeof(int16_t));
+	}
+public:
+	ToneBank() {
+		params = {};
+		nSamplesPerTone = 0;
+		isGenerating = false;
+	}
+
+	ToneBank(const ToneBank&) = delete;
+	ToneBank& operator=(const ToneBank&) = delete;
+
+	// The queued blocks write into this bank
+	~ToneBank() {
+		for (auto& block : pending) block.wait();
+	}
+
+	static ToneParams DefaultParams(uint32_t nTones) {
+		return { nTones, 44100, 0.3f, 261.63f, 0.005f, 0.08f, 0.6f };
+	}
+
+	static float GetToneFrequency(const ToneParams& params, uint32_t tone) {
+		static const uint32_t pentatonic[5] = { 0, 2, 4, 7, 9 };
+		uint32_t semitones = 12 * (tone / 5) + pentatonic[tone % 5];
+		return params.baseFrequency * std::pow(2.0f, semitones / 12.0f);
+	}
+
+	// Loads the bank from the cache when it holds one with the same parameters, otherwise synthesizes it
+	// on the pool and writes the cache. Must not be called from inside a pool task
+	bool Generate(const ToneParams& toneParams, ThreadPool& pool, const std::string& cacheDirectory = "files/cache") {
+		GenerateAsync(toneParams, pool, cacheDirectory);
+		return Wait();
+	}
+
+	// Like Generate, but returns as soon as the synthesis is queued; Wait finishes it. A cached bank is
+	// loaded at once, since reading it costs less than a frame
+	void GenerateAsync(const ToneParams& toneParams, ThreadPool& pool, const std::string& cacheDirectory = "files/cache") {
+		Wait();
+
+		params = toneParams;
+		nSamplesPerTone = (uint32_t)std::lround(params.duration * params.sampleRate);
+
+		char name[32];
+		std::snprintf(name, sizeof(name), "tones_%016llx.bin", (unsigned long long)HashParams(params));
+		cachePath = cacheDirectory + "/" + name;
+
+		if (LoadCache(cachePath)) return;
+
+		samples.assign((std::size_t)params.nTones * nSamplesPerTone, 0);
+		uint32_t nBlocks = (nSamplesPerTone + BlockSize - 1) / BlockSize;
+		std::size_t nItems = (std::size_t)params.nTones * nBlocks;
+		uint32_t nTasks = (uint32_t)(std::min<std::size_t>)(pool.GetThreadCount(), nItems);
+
+		// One contiguous share of the blocks per worker; every block costs the same
+		for (uint32_t task = 0; task < nTasks; task++) {
+			std::size_t begin = nItems * task / nTasks, end = nItems * (task + 1) / nTasks;
+			pending.push_back(pool.Submit([this, begin, end, nBlocks] {
+				for (std::size_t k = begin; k < end; k++) {
+					uint32_t tone = (uint32_t)(k / nBlocks), block = (uint32_t)(k % nBlocks);
+					uint32_t first = block * BlockSize, last = (std::min)(first + BlockSize, nSamplesPerTone);
+					Synthesize(GetToneFrequency(params, tone), params, nSamplesPerTone, first, last, samples.data() + (std::size_t)tone * nSamplesPerTone);
+				}
+			}));
+		}
+		isGenerating = true;
+	}
+
+	// Blocks until a GenerateAsync is done, then creates the buffers and writes the cache
+	bool Wait() {
+		if (!isGenerating) return buffers.size() == params.nTones;
+		isGenerating = false;
+
+		for (auto& block : pending) block.get();
+		pending.clear();
+
+		bool isLoaded = LoadFromSamples(samples.data());
+		if (isLoaded) SaveCache(cachePath, samples);
+		else std::cout << "Couldn't create the tone bank" << std::endl;
+
+		samples.clear();
+		samples.shrink_to_fit();
+		return isLoaded;
+	}
+
+	inline const sf::SoundBuffer& GetBuffer(uint32_t tone) const { return buffers[tone]; }
+	inline uint32_t GetToneCount() const { return (uint32_t)buffers.size(); }
+};
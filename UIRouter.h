@@ -0,0 +1,212 @@
+#pragma once
+#include <SFML/Window/Event.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+// Receives only the events it subscribed to through UIRouter::Add
+class UIWidget {
+public:
+	virtual ~UIWidget() {}
+
+	virtual void OnMouseEnter() {}
+	virtual void OnMouseLeave() {}
+	virtual void OnMousePress(sf::Mouse::Button) {}
+	// Sent to the widget that got the press, also when the cursor was released outside of it
+	virtual void OnMouseRelease(sf::Mouse::Button, bool) {}
+	virtual void OnMouseWheel(float) {}
+	// Keyboard and text events, which have no position and go to every subscriber
+	virtual void OnEvent(const sf::Event&) {}
+};
+
+// Routes mouse events only to the widget under the cursor. Widget bounds are bucketed into a uniform
+// grid, so a hit test looks at the few widgets sharing one cell instead of every widget on the screen
+class UIRouter {
+public:
+	enum EventMask : uint32_t {
+		Hover = 1 << 0,
+		Press = 1 << 1,
+		Release = 1 << 2,
+		Wheel = 1 << 3,
+		Key = 1 << 4,
+		Text = 1 << 5,
+		Mouse = Hover | Press | Release,
+		All = Mouse | Wheel | Key | Text
+	};
+private:
+	struct Entry {
+		UIWidget* widget;
+		float left, top, right, bottom;
+		uint32_t events;
+		bool isEnabled;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<uint32_t> cellStart, cellItems; // Widget ids of cell i are cellItems[cellStart[i], cellStart[i + 1])
+	std::vector<uint32_t> keySubscribers, textSubscribers;
+
+	float originX, originY, cellSize;
+	int32_t nCellsX, nCellsY;
+	bool isGridDirty;
+
+	int32_t hovered, captured;
+
+	void CellRange(const Entry& entry, int32_t& x0, int32_t& y0, int32_t& x1, int32_t& y1) const {
+		x0 = (std::max)(0, (int32_t)((entry.left - originX) / cellSize));
+		y0 = (std::max)(0, (int32_t)((entry.top - originY) / cellSize));
+		x1 = (std::min)(nCellsX - 1, (int32_t)((entry.right - originX) / cellSize));
+		y1 = (std::min)(nCellsY - 1, (int32_t)((entry.bottom - originY) / cellSize));
+	}
+
+	// Counting pass, prefix sum, then fill; cells keep widgets in insertion order
+	void RebuildGrid() {
+		cellStart.assign((std::size_t)nCellsX * nCellsY + 1, 0);
+
+		int32_t x0, y0, x1, y1;
+		for (const auto& entry : entries) {
+			CellRange(entry, x0, y0, x1, y1);
+			for (int32_t y = y0; y <= y1; y++) {
+				for (int32_t x = x0; x <= x1; x++) cellStart[(std::size_t)y * nCellsX + x + 1]++;
+			}
+		}
+
+		for (std::size_t i = 1; i < cellStart.size(); i++) cellStart[i] += cellStart[i - 1];
+
+		cellItems.resize(cellStart.back());
+		std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+		for (uint32_t id = 0; id < (uint32_t)entries.size(); id++) {
+			CellRange(entries[id], x0, y0, x1, y1);
+			for (int32_t y = y0; y <= y1; y++) {
+				for (int32_t x = x0; x <= x1; x++) cellItems[fill[(std::size_t)y * nCellsX + x]++] = id;
+			}
+		}
+
+		isGridDirty = false;
+	}
+
+	static bool Contains(const Entry& entry, float x, float y) {
+		return x >= entry.left && x < entry.right && y >= entry.top && y < entry.bottom;
+	}
+
+	void SetHovered(int32_t id) {
+		if (id == hovered) return;
+
+		if (hovered >= 0 && (entries[hovered].events & Hover)) entries[hovered].widget->OnMouseLeave();
+		hovered = id;
+		if (hovered >= 0 && (entries[hovered].events & Hover)) entries[hovered].widget->OnMouseEnter();
+	}
+public:
+	UIRouter(const sf::FloatRect& area, float cellSize = 64.0f)
+		: originX(area.left), originY(area.top), cellSize(cellSize) {
+		nCellsX = (std::max)(1, (int32_t)((area.width + cellSize - 1.0f) / cellSize));
+		nCellsY = (std::max)(1, (int32_t)((area.height + cellSize - 1.0f) / cellSize));
+		isGridDirty = true;
+		hovered = -1;
+		captured = -1;
+	}
+
+	// Returns the widget id; ids are handed out in order, and a widget added later sits on top
+	uint32_t Add(UIWidget* widget, const sf::FloatRect& bounds, uint32_t events = Mouse) {
+		uint32_t id = (uint32_t)entries.size();
+		entries.push_back({ widget, bounds.left, bounds.top, bounds.left + bounds.width, bounds.top + bounds.height, events, true });
+
+		if (events & Key) keySubscribers.push_back(id);
+		if (events & Text) textSubscribers.push_back(id);
+
+		isGridDirty = true;
+		return id;
+	}
+
+	void SetBounds(uint32_t id, const sf::FloatRect& bounds) {
+		Entry& entry = entries[id];
+		entry.left = bounds.left;
+		entry.top = bounds.top;
+		entry.right = bounds.left + bounds.width;
+		entry.bottom = bounds.top + bounds.height;
+		isGridDirty = true;
+	}
+
+	void SetEnabled(uint32_t id, bool isEnabled) {
+		entries[id].isEnabled = isEnabled;
+		if (!isEnabled && hovered == (int32_t)id) SetHovered(-1);
+		if (!isEnabled && captured == (int32_t)id) captured = -1;
+	}
+
+	// Forgets the hovered and captured widgets without notifying them, e.g. when a screen is left
+	void Reset() {
+		hovered = -1;
+		captured = -1;
+	}
+
+	// Topmost enabled widget at the position that subscribed to any of the events in mask, or -1
+	int32_t HitTest(const sf::Vector2f& position, uint32_t mask = Mouse) {
+		if (isGridDirty) RebuildGrid();
+
+		int32_t x = (int32_t)std::floor((position.x - originX) / cellSize);
+		int32_t y = (int32_t)std::floor((position.y - originY) / cellSize);
+		if (x < 0 || y < 0 || x >= nCellsX || y >= nCellsY) return -1;
+
+		std::size_t cell = (std::size_t)y * nCellsX + x;
+		for (uint32_t i = cellStart[cell + 1]; i > cellStart[cell]; i--) {
+			uint32_t id = cellItems[i - 1];
+			const Entry& entry = entries[id];
+			if (entry.isEnabled && (entry.events & mask) && Contains(entry, position.x, position.y)) return (int32_t)id;
+		}
+
+		return -1;
+	}
+
+	// Returns the id of the widget that received a mouse press, or -1
+	int32_t Dispatch(const sf::Event& e, const sf::Vector2f& mousePos) {
+		switch (e.type) {
+		case sf::Event::MouseMoved:
+			if (captured < 0) SetHovered(HitTest(mousePos, Hover));
+			break;
+		case sf::Event::MouseButtonPressed: {
+			int32_t id = HitTest(mousePos, Press | Release);
+			if (id < 0) return -1;
+
+			captured = id;
+			if (entries[id].events & Press) entries[id].widget->OnMousePress(e.mouseButton.button);
+			return id;
+		}
+		case sf::Event::MouseButtonReleased:
+			if (captured >= 0) {
+				Entry& entry = entries[captured];
+				captured = -1;
+				if (entry.events & Release) entry.widget->OnMouseRelease(e.mouseButton.button, Contains(entry, mousePos.x, mousePos.y));
+			}
+			SetHovered(HitTest(mousePos, Hover));
+			break;
+		case sf::Event::MouseWheelScrolled: {
+			int32_t id = HitTest(mousePos, Wheel);
+			if (id >= 0) entries[id].widget->OnMouseWheel(e.mouseWheelScroll.delta);
+			break;
+		}
+		case sf::Event::MouseLeft:
+			if (captured < 0) SetHovered(-1);
+			break;
+		case sf::Event::KeyPressed:
+		case sf::Event::KeyReleased:
+			for (uint32_t id : keySubscribers) {
+				if (entries[id].isEnabled) entries[id].widget->OnEvent(e);
+			}
+			break;
+		case sf::Event::TextEntered:
+			for (uint32_t id : textSubscribers) {
+				if (entries[id].isEnabled) entries[id].widget->OnEvent(e);
+			}
+			break;
+		default:
+			break;
+		}
+
+		return -1;
+	}
+
+	inline int32_t GetHovered() const { return hovered; }
+	inline int32_t GetCaptured() const { return captured; }
+	inline std::size_t GetWidgetCount() const { return entries.size(); }
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <SFML/Audio/Sound.hpp>
+#include <SFML/Audio/SoundBuffer.hpp>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include "Profiler.h"
+
+// Fixed set of sf::Sound voices shared by a screen. Buffers are bound once and played by binding id,
+// so a trigger does no lookups. A binding may hold at most maxVoicesPerBinding voices; past that, or
+// when every voice is busy, the voice that started longest ago is stolen
+class VoicePool {
+public:
+	struct LatencyStats {
+		uint64_t count;
+		double averageMicroseconds, maxMicroseconds;
+	};
+private:
+	struct Voice {
+		sf::Sound sound;
+		int32_t binding;
+		uint64_t startOrder;
+	};
+
+	std::vector<Voice> voices;
+	std::vector<const sf::SoundBuffer*> bindings;
+	uint32_t maxVoicesPerBinding;
+	uint64_t nStarted;
+
+	uint64_t latencyCount;
+	double latencySum, latencyMax;
+
+	uint32_t PickVoice(int32_t binding) {
+		uint32_t nBound = 0, oldestBound = 0, oldest = 0, freeVoice = (uint32_t)voices.size();
+
+		for (uint32_t i = 0; i < (uint32_t)voices.size(); i++) {
+			const Voice& voice = voices[i];
+			if (voice.sound.getStatus() != sf::Sound::Playing) {
+				if (freeVoice == voices.size()) freeVoice = i;
+				continue;
+			}
+
+			if (voice.binding == binding && (nBound++ == 0 || voice.startOrder < voices[oldestBound].startOrder)) oldestBound = i;
+			if (voice.startOrder < voices[oldest].startOrder) oldest = i; // Only used once every voice is playing
+		}
+
+		if (nBound >= maxVoicesPerBinding) return oldestBound;
+		if (freeVoice < voices.size()) return freeVoice;
+		return oldest;
+	}
+public:
+	VoicePool(uint32_t nVoices = 8, uint32_t maxVoicesPerBinding = 2)
+		: voices(nVoices), maxVoicesPerBinding((std::max)(1u, maxVoicesPerBinding)) {
+		for (auto& voice : voices) {
+			voice.binding = -1;
+			voice.startOrder = 0;
+		}
+		nStarted = 0;
+		latencyCount = 0;
+		latencySum = 0.0;
+		latencyMax = 0.0;
+	}
+
+	uint32_t Bind(const sf::SoundBuffer& buffer) {
+		bindings.push_back(&buffer);
+		return (uint32_t)bindings.size() - 1;
+	}
+
+	void Rebind(uint32_t binding, const sf::SoundBuffer& buffer) {
+		bindings[binding] = &buffer;
+		for (auto& voice : voices) {
+			if (voice.binding == (int32_t)binding) {
+				voice.sound.stop();
+				voice.binding = -1;
+			}
+		}
+	}
+
+	inline std::size_t GetBindingCount() const { return bindings.size(); }
+
+	// eventTime is when the triggering input arrived; the time until play() returns is recorded
+	void Play(uint32_t binding, std::chrono::steady_clock::time_point eventTime) {
+		PROFILE_ZONE("VoicePool::Play");
+
+		Voice& voice = voices[PickVoice((int32_t)binding)];
+		voice.sound.stop();
+		if (voice.binding != (int32_t)binding) {
+			voice.sound.setBuffer(*bindings[binding]);
+			voice.binding = (int32_t)binding;
+		}
+		voice.startOrder = ++nStarted;
+		voice.sound.play();
+
+		double latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - eventTime).count();
+		latencyCount++;
+		latencySum += latency;
+		latencyMax = (std::max)(latencyMax, latency);
+	}
+
+	void Play(uint32_t binding) {
+		Play(binding, std::chrono::steady_clock::now());
+	}
+
+	void StopAll() {
+		for (auto& voice : voices) voice.sound.stop();
+	}
+
+	void PauseAll() {
+		for (auto& voice : voices) {
+			if (voice.sound.getStatus() == sf::Sound::Playing) voice.sound.pause();
+		}
+	}
+
+	void ResumeAll() {
+		for (auto& voice : voices) {
+			if (voice.sound.getStatus() == sf::Sound::Paused) voice.sound.play();
+		}
+	}
+
+	LatencyStats GetLatencyStats() const {
+		return { latencyCount, latencyCount ? latencySum / latencyCount : 0.0, latencyMax };
+	}
+};
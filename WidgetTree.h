@@ -0,0 +1,451 @@
+#pragma once
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/PrimitiveType.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include "UIRouter.h"
+#include "Profiler.h"
+#include "RenderSurface.h"
+
+// Retained UI: nodes are boxes with an optional centred label, positioned relative to their parent.
+// All boxes share one quad array and all labels of a character size share one glyph batch over the
+// font's atlas, so a screen is drawn in one call plus one per character size; a textured box splits
+// the quad array into one more call for its fill and one for what follows. Setters only mark a node
+// dirty; Update rewrites the vertices of dirty nodes in place and relays out a glyph batch only when
+// the glyph count of one of its labels changed
+class WidgetTree {
+private:
+	static const uint32_t BoxVertexCount = 20; // Fill and four outline bars
+
+	struct Node {
+		float x, y, width, height; // Relative to the parent
+		float left, top; // Resolved in window coordinates
+		int32_t parent;
+		uint32_t childCount;
+
+		sf::Color fill, outlineColor, textColor;
+		const sf::Texture* texture; // Only for the fill
+		sf::IntRect textureRect;
+		float outlineThickness;
+		std::string text;
+		uint32_t characterSize;
+		bool isVisible;
+		bool isDirty;
+
+		uint32_t batch; // Index into textBatches
+		uint32_t glyphOffset, glyphCount; // Vertex range of the label in its batch
+	};
+
+	// A range of the quad array drawn with one texture
+	struct QuadRun {
+		std::size_t first, count;
+		const sf::Texture* texture;
+	};
+
+	struct TextBatch {
+		uint32_t characterSize;
+		std::vector<sf::Vertex> vertices;
+		bool isDirty;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> dirtyNodes;
+	std::vector<sf::Vertex> quads;
+	std::vector<QuadRun> quadRuns;
+	std::vector<TextBatch> textBatches;
+	const sf::Font* font;
+	bool isLayoutDirty;
+
+	void MarkDirty(uint32_t id) {
+		if (!nodes[id].isDirty) {
+			nodes[id].isDirty = true;
+			dirtyNodes.push_back(id);
+		}
+	}
+
+	bool IsShown(uint32_t id) const {
+		for (int32_t i = (int32_t)id; i >= 0; i = nodes[i].parent) {
+			if (!nodes[i].isVisible) return false;
+		}
+		return true;
+	}
+
+	uint32_t FindBatch(uint32_t characterSize) {
+		for (uint32_t i = 0; i < (uint32_t)textBatches.size(); i++) {
+			if (textBatches[i].characterSize == characterSize) return i;
+		}
+
+		textBatches.push_back({ characterSize, {}, true });
+		return (uint32_t)textBatches.size() - 1;
+	}
+
+	static void WriteQuad(sf::Vertex* v, float left, float top, float right, float bottom, sf::Color color) {
+		v[0] = sf::Vertex({ left, top }, color);
+		v[1] = sf::Vertex({ right, top }, color);
+		v[2] = sf::Vertex({ right, bottom }, color);
+		v[3] = sf::Vertex({ left, bottom }, color);
+	}
+
+	// A positive thickness grows the outline outwards and a negative one inwards, as with sf::Shape
+	void WriteBox(uint32_t id) {
+		const Node& node = nodes[id];
+		sf::Vertex* v = &quads[(std::size_t)id * BoxVertexCount];
+
+		if (!IsShown(id)) {
+			for (uint32_t i = 0; i < BoxVertexCount; i++) v[i] = sf::Vertex({ 0.0f, 0.0f }, sf::Color::Transparent);
+			return;
+		}
+
+		float left = node.left, top = node.top, right = left + node.width, bottom = top + node.height;
+		WriteQuad(v, left, top, right, bottom, node.fill);
+		if (node.texture) {
+			float u1 = (float)node.textureRect.left, v1 = (float)node.textureRect.top;
+			float u2 = u1 + node.textureRect.width, v2 = v1 + node.textureRect.height;
+			v[0].texCoords = { u1, v1 };
+			v[1].texCoords = { u2, v1 };
+			v[2].texCoords = { u2, v2 };
+			v[3].texCoords = { u1, v2 };
+		}
+
+		float t = node.outlineThickness;
+		float outerLeft = t > 0.0f ? left - t : left, outerTop = t > 0.0f ? top - t : top;
+		float outerRight = t > 0.0f ? right + t : right, outerBottom = t > 0.0f ? bottom + t : bottom;
+		float innerLeft = t > 0.0f ? left : left - t, innerTop = t > 0.0f ? top : top - t;
+		float innerRight = t > 0.0f ? right : right + t, innerBottom = t > 0.0f ? bottom : bottom + t;
+
+		WriteQuad(v + 4, outerLeft, outerTop, outerRight, innerTop, node.outlineColor);
+		WriteQuad(v + 8, outerLeft, innerBottom, outerRight, outerBottom, node.outlineColor);
+		WriteQuad(v + 12, outerLeft, innerTop, innerLeft, innerBottom, node.outlineColor);
+		WriteQuad(v + 16, innerRight, innerTop, outerRight, innerBottom, node.outlineColor);
+	}
+
+	// Same glyph placement as sf::Text, one quad per character so the count only depends on the length
+	void WriteGlyphs(uint32_t id) {
+		const Node& node = nodes[id];
+		sf::Vertex* v = textBatches[node.batch].vertices.data() + node.glyphOffset;
+
+		if (!IsShown(id) || !font) {
+			for (uint32_t i = 0; i < node.glyphCount; i++) v[i] = sf::Vertex({ 0.0f, 0.0f }, sf::Color::Transparent);
+			return;
+		}
+
+		float width = 0.0f;
+		uint32_t prev = 0;
+		for (char c : node.text) {
+			uint32_t ch = (uint8_t)c;
+			width += font->getKerning(prev, ch, node.characterSize) + font->getGlyph(ch, node.characterSize, false).advance;
+			prev = ch;
+		}
+
+		float x = std::floor(node.left + (node.width - width) / 2.0f);
+		float y = std::floor(node.top + (node.height - node.characterSize) / 2.0f) + node.characterSize;
+
+		prev = 0;
+		for (char c : node.text) {
+			uint32_t ch = (uint8_t)c;
+			x += font->getKerning(prev, ch, node.characterSize);
+			prev = ch;
+
+			const sf::Glyph& glyph = font->getGlyph(ch, node.characterSize, false);
+			float left = x + glyph.bounds.left, top = y + glyph.bounds.top;
+			float right = left + glyph.bounds.width, bottom = top + glyph.bounds.height;
+			float u1 = (float)glyph.textureRect.left, v1 = (float)glyph.textureRect.top;
+			float u2 = u1 + glyph.textureRect.width, v2 = v1 + glyph.textureRect.height;
+
+			v[0] = sf::Vertex({ left, top }, node.textColor, { u1, v1 });
+			v[1] = sf::Vertex({ right, top }, node.textColor, { u2, v1 });
+			v[2] = sf::Vertex({ right, bottom }, node.textColor, { u2, v2 });
+			v[3] = sf::Vertex({ left, bottom }, node.textColor, { u1, v2 });
+			v += 4;
+
+			x += glyph.advance;
+		}
+	}
+
+	void RebuildBatch(uint32_t batchIndex) {
+		TextBatch& batch = textBatches[batchIndex];
+
+		uint32_t nVertices = 0;
+		for (auto& node : nodes) {
+			if (node.text.empty() || node.batch != batchIndex) continue;
+			node.glyphOffset = nVertices;
+			node.glyphCount = (uint32_t)node.text.size() * 4;
+			nVertices += node.glyphCount;
+		}
+
+		batch.vertices.resize(nVertices);
+		for (uint32_t id = 0; id < (uint32_t)nodes.size(); id++) {
+			if (!nodes[id].text.empty() && nodes[id].batch == batchIndex) WriteGlyphs(id);
+		}
+
+		batch.isDirty = false;
+	}
+
+	void Rebuild() {
+		for (auto& node : nodes) {
+			node.left = node.x;
+			node.top = node.y;
+			if (node.parent >= 0) {
+				node.left += nodes[node.parent].left;
+				node.top += nodes[node.parent].top;
+			}
+			node.isDirty = false;
+		}
+		dirtyNodes.clear();
+
+		quads.resize(nodes.size() * BoxVertexCount);
+		for (uint32_t id = 0; id < (uint32_t)nodes.size(); id++) WriteBox(id);
+
+		// Consecutive untextured boxes, outlines included, stay one draw call
+		quadRuns.clear();
+		auto AddRun = [&](std::size_t first, std::size_t count, const sf::Texture* texture) {
+			if (!quadRuns.empty() && quadRuns.back().texture == texture && quadRuns.back().first + quadRuns.back().count == first) quadRuns.back().count += count;
+			else quadRuns.push_back({ first, count, texture });
+		};
+		for (uint32_t id = 0; id < (uint32_t)nodes.size(); id++) {
+			std::size_t first = (std::size_t)id * BoxVertexCount;
+			if (nodes[id].texture) {
+				AddRun(first, 4, nodes[id].texture);
+				AddRun(first + 4, BoxVertexCount - 4, nullptr);
+			}
+			else AddRun(first, BoxVertexCount, nullptr);
+		}
+
+		for (uint32_t i = 0; i < (uint32_t)textBatches.size(); i++) RebuildBatch(i);
+
+		isLayoutDirty = false;
+	}
+public:
+	WidgetTree() {
+		font = nullptr;
+		isLayoutDirty = true;
+	}
+
+	void SetFont(const sf::Font& newFont) {
+		if (font == &newFont) return;
+
+		font = &newFont;
+		isLayoutDirty = true;
+	}
+
+	// Returns the node id. Parents must be added before their children; -1 is the window
+	uint32_t Add(int32_t parent, const sf::Vector2f& position, const sf::Vector2f& size, sf::Color fill = sf::Color::Transparent) {
+		Node node;
+		node.x = position.x;
+		node.y = position.y;
+		node.width = size.x;
+		node.height = size.y;
+		node.left = 0.0f;
+		node.top = 0.0f;
+		node.parent = parent;
+		node.childCount = 0;
+		node.fill = fill;
+		node.outlineColor = sf::Color::Transparent;
+		node.textColor = sf::Color::White;
+		node.texture = nullptr;
+		node.outlineThickness = 0.0f;
+		node.characterSize = 0;
+		node.isVisible = true;
+		node.isDirty = false;
+		node.batch = 0;
+		node.glyphOffset = 0;
+		node.glyphCount = 0;
+
+		if (parent >= 0) nodes[parent].childCount++;
+		nodes.push_back(node);
+		isLayoutDirty = true;
+		return (uint32_t)nodes.size() - 1;
+	}
+
+	void SetFillColor(uint32_t id, sf::Color color) {
+		if (nodes[id].fill == color) return;
+
+		nodes[id].fill = color;
+		MarkDirty(id);
+	}
+
+	// The fill color tints the texture, as with sf::Shape. An empty rect maps the whole texture
+	void SetTexture(uint32_t id, const sf::Texture* texture, const sf::IntRect& textureRect = sf::IntRect()) {
+		sf::IntRect rect = textureRect;
+		if (texture && rect.width == 0 && rect.height == 0) rect = sf::IntRect(0, 0, (int)texture->getSize().x, (int)texture->getSize().y);
+		if (nodes[id].texture == texture && nodes[id].textureRect == rect) return;
+
+		nodes[id].texture = texture;
+		nodes[id].textureRect = rect;
+		isLayoutDirty = true;
+	}
+
+	void SetOutline(uint32_t id, float thickness, sf::Color color) {
+		if (nodes[id].outlineThickness == thickness && nodes[id].outlineColor == color) return;
+
+		nodes[id].outlineThickness = thickness;
+		nodes[id].outlineColor = color;
+		MarkDirty(id);
+	}
+
+	void SetText(uint32_t id, const std::string& str, uint32_t characterSize = 32, sf::Color color = sf::Color::White) {
+		Node& node = nodes[id];
+		if (node.text == str && node.characterSize == characterSize && node.textColor == color) return;
+
+		uint32_t batch = str.empty() ? node.batch : FindBatch(characterSize);
+		if (str.size() != node.text.size() || batch != node.batch) {
+			if (!node.text.empty()) textBatches[node.batch].isDirty = true;
+			if (!str.empty()) textBatches[batch].isDirty = true;
+		}
+
+		node.text = str;
+		node.characterSize = characterSize;
+		node.textColor = color;
+		node.batch = batch;
+		MarkDirty(id);
+	}
+
+	// Moving a node without children only rewrites its own vertices; anything else relays out the tree
+	void SetPosition(uint32_t id, const sf::Vector2f& position) {
+		Node& node = nodes[id];
+		if (node.x == position.x && node.y == position.y) return;
+
+		node.x = position.x;
+		node.y = position.y;
+		if (node.childCount > 0 || isLayoutDirty) {
+			isLayoutDirty = true;
+			return;
+		}
+
+		node.left = node.x + (node.parent >= 0 ? nodes[node.parent].left : 0.0f);
+		node.top = node.y + (node.parent >= 0 ? nodes[node.parent].top : 0.0f);
+		MarkDirty(id);
+	}
+
+	// Children keep their position relative to the node's top left corner
+	void SetSize(uint32_t id, const sf::Vector2f& size) {
+		if (nodes[id].width == size.x && nodes[id].height == size.y) return;
+
+		nodes[id].width = size.x;
+		nodes[id].height = size.y;
+		MarkDirty(id);
+	}
+
+	// Hides the node and all of its children
+	void SetVisible(uint32_t id, bool isVisible) {
+		if (nodes[id].isVisible == isVisible) return;
+
+		nodes[id].isVisible = isVisible;
+		if (nodes[id].childCount > 0) isLayoutDirty = true;
+		else MarkDirty(id);
+	}
+
+	void Update() {
+		PROFILE_ZONE("WidgetTree::Update");
+
+		if (isLayoutDirty) {
+			Rebuild();
+			return;
+		}
+
+		for (uint32_t id : dirtyNodes) {
+			nodes[id].isDirty = false;
+			WriteBox(id);
+			if (!nodes[id].text.empty() && !textBatches[nodes[id].batch].isDirty) WriteGlyphs(id);
+		}
+		dirtyNodes.clear();
+
+		for (uint32_t i = 0; i < (uint32_t)textBatches.size(); i++) {
+			if (textBatches[i].isDirty) RebuildBatch(i);
+		}
+	}
+
+	void Render(RenderSurface& surface) {
+		Update();
+
+		PROFILE_ZONE("WidgetTree::Render");
+		for (auto& run : quadRuns) surface.Draw(quads.data() + run.first, run.count, sf::Quads, sf::RenderStates(run.texture));
+
+		if (!font) return;
+		for (auto& batch : textBatches) {
+			if (!batch.vertices.empty()) surface.Draw(batch.vertices.data(), batch.vertices.size(), sf::Quads, sf::RenderStates(&font->getTexture(batch.characterSize)));
+		}
+	}
+
+	// Window coordinates; valid once the layout has been updated
+	sf::FloatRect GetBounds(uint32_t id) {
+		if (isLayoutDirty) Rebuild();
+		return sf::FloatRect(nodes[id].left, nodes[id].top, nodes[id].width, nodes[id].height);
+	}
+
+	inline sf::Color GetFillColor(uint32_t id) const { return nodes[id].fill; }
+	inline std::size_t GetNodeCount() const { return nodes.size(); }
+};
+
+// Button whose box and label live in a WidgetTree and that takes the UIRouter callbacks, so hover and
+// press only rewrite the vertices of this one node
+class RetainedButton : public UIWidget {
+private:
+	WidgetTree* tree;
+	uint32_t node;
+	sf::Color colors[3];
+	bool onPress;
+public:
+	enum ButtonState {
+		MousePressed = 0,
+		MouseHover = 1,
+		MouseRelease = 2
+	};
+
+	RetainedButton() {
+		tree = nullptr;
+		node = 0;
+		onPress = false;
+	}
+
+	void Initialize(WidgetTree& widgetTree, const sf::Vector2f& pos, const sf::Vector2f& buttonBoxSize, int32_t parent = -1) {
+		tree = &widgetTree;
+		node = tree->Add(parent, pos, buttonBoxSize);
+	}
+
+	void SetColors(const sf::Color& onPress, const sf::Color& onHover, const sf::Color& onRelease) {
+		colors[MousePressed] = onPress;
+		colors[MouseHover] = onHover;
+		colors[MouseRelease] = onRelease;
+	}
+
+	void SetOutline(float thickness, const sf::Color& color) { tree->SetOutline(node, thickness, color); }
+	void SetLabel(const std::string& str, uint32_t characterSize = 32, sf::Color color = sf::Color::White) { tree->SetText(node, str, characterSize, color); }
+	void SetFillColor(const sf::Color& color) { tree->SetFillColor(node, color); }
+
+	void ResetColor() {
+		onPress = false;
+		tree->SetFillColor(node, colors[MouseRelease]);
+	}
+
+	inline sf::Color const* GetColors() const { return colors; }
+	inline uint32_t GetNode() const { return node; }
+	sf::FloatRect GetBounds() const { return tree->GetBounds(node); }
+
+	void OnMouseEnter() override {
+		if (!onPress) tree->SetFillColor(node, colors[MouseHover]);
+	}
+
+	void OnMouseLeave() override {
+		if (!onPress) tree->SetFillColor(node, colors[MouseRelease]);
+	}
+
+	void OnMousePress(sf::Mouse::Button button) override {
+		if (button == sf::Mouse::Left) {
+			tree->SetFillColor(node, colors[MousePressed]);
+			onPress = true;
+		}
+	}
+
+	void OnMouseRelease(sf::Mouse::Button button, bool isInside) override {
+		if (button == sf::Mouse::Left) {
+			tree->SetFillColor(node, colors[isInside ? MouseHover : MouseRelease]);
+			onPress = false;
+		}
+	}
+};
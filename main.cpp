@@ -4,375 +4,694 @@
 #include "GraphicsUI.h"
 #include "AssetManager.h"
 #include "GraphicsRender.h"
+#include "SequenceGame.h"
+#include "Random.h"
+#include "InputJournal.h"
+#include "WidgetTree.h"
+#include "VoicePool.h"
+#include "ToneBank.h"
+#include "TileBoard.h"
+#include <functional>
+#include <chrono>
+#include <charconv>
+#include <cstring>
 #include <ctime>
+#include <cstdio>
 
 class GameState {
 public:
 	enum State {
 		Menu = 0,
 		Play = 1,
-		HighScore = 2,
-		Quit = 3
-	} state;
+		Pause = 2,
+		HighScore = 3,
+		Quit = 4, //Closes the game; never created
+		StateCount = 5
+	} state; //State requested by the last ChangeState
+
+	enum Transition {
+		Switch = 0, //Replace the whole stack with state
+		Push = 1, //Open state as an overlay above this one
+		Pop = 2 //Close this state and return to the one below
+	} transition;
 
 	bool isStateChanged;
-	GameState() {
+	bool isPreloadRequested;
+	State preloadState;
+	float interpolation; //Fraction of a simulation tick elapsed since the last Logic call, for Render
+	Random random;
+
+	GameState(uint64_t seed)
+		: random(seed) {
+		state = Menu;
+		transition = Switch;
 		isStateChanged = false;
-		LoadAssets();
+		isPreloadRequested = false;
+		preloadState = Menu;
+		interpolation = 0.0f;
 	}
+	virtual ~GameState() {}
 
-	virtual void Logic() = 0;
+	void ChangeState(State next, Transition how = Switch) {
+		state = next;
+		transition = how;
+		isStateChanged = true;
+	}
+
+	//Creates the state ahead of time. Constructors only queue their heavy work (assets, tones) on the
+	//loader pool, so it runs while this state does; OnEnter waits for whatever is still unfinished
+	void Preload(State next) {
+		preloadState = next;
+		isPreloadRequested = true;
+	}
+
+	//States are created once and kept alive; OnEnter/OnExit run each time one is put on or taken off the stack
+	virtual void OnEnter() {}
+	virtual void OnExit() {}
+	//OnPause runs when another state is pushed over this one, OnResume when it is popped again
+	virtual void OnPause() {}
+	virtual void OnResume() {}
+	//An overlay is rendered over the states below it, which stay on the stack without input or ticks
+	virtual bool IsOverlay() const { return false; }
+
+	virtual void Logic(float dt) = 0;
 	virtual void ManageEvent(sf::Event, sf::Vector2f) {}
-	virtual void Render(sf::RenderWindow&) = 0;
+	virtual void Render(RenderSurface&) = 0;
 
-	void LoadAssets() {
-		AssetHolder::Get().AddSoundBuffer("beep1", "files/sounds/beep1.wav");
-		AssetHolder::Get().AddSoundBuffer("beep2", "files/sounds/beep2.wav");
-		AssetHolder::Get().AddSoundBuffer("beep3", "files/sounds/beep3.wav");
-		AssetHolder::Get().AddSoundBuffer("beep4", "files/sounds/beep4.wav");
+	// Assets shared by every state; each state queues its own in its constructor and blocks only on assets it touches
+	static void LoadAssets() {
+		AssetHolder::Get().MountArchive("files/assets.pak");
 
 		AssetHolder::Get().AddFont("sansationBold", "files/fonts/Sansation_Bold.ttf");
-
-		AssetHolder::Get().AddTexture("gameTitle", "files/images/gameTitle.png");
 	}
 };
 
 class MenuState : public GameState {
 private:
-	std::vector<Button> buttons;
+	WidgetTree widgets;
+	std::vector<RetainedButton> buttons;
 	sf::Vector2f buttonSize;
 	sf::Sprite gameTitle;
 
 	const std::string buttonNames[2] = { "Play", "Quit" };
+	AssetHandle<sf::Font> font;
+	AssetHandle<sf::Texture> titleTexture;
+	bool isTitleBound;
+	UIRouter router;
 public:
-	MenuState() {
+	MenuState(uint64_t seed)
+		: GameState(seed), router({ 0.0f, 0.0f, 485.0f, 515.0f }) {
 
-		LoadAssets();
+		font = AssetHolder::Get().GetFontHandle("sansationBold");
+		titleTexture = AssetHolder::Get().AddTexture("gameTitle", "files/images/gameTitle.png");
+		isTitleBound = false;
 
 		buttonSize = { 200.0f, 50.0f };
 
+		buttons.resize(2);
 		for (int i = 0; i < 2; i++) {
-			buttons.push_back(Button());
-			buttons[i].Initialize({ 142.25f, 300.0f + (i * (buttonSize.y + 10.0f)) }, buttonSize);
-			
-			sf::Color randColor = sf::Color(rand() % 100, rand() % 100, rand() % 100);
+			buttons[i].Initialize(widgets, { 142.25f, 300.0f + (i * (buttonSize.y + 10.0f)) }, buttonSize);
+			buttons[i].SetLabel(buttonNames[i]);
+			router.Add(&buttons[i], buttons[i].GetBounds());
+		}
+	
+		gameTitle.setPosition({ 8.0f, 10.0f });
+	}
+
+	void OnEnter() override {
+		for (auto& button : buttons) {
+			sf::Color randColor = sf::Color(random.Next(100), random.Next(100), random.Next(100));
 
-			buttons[i].SetColors(sf::Color(randColor.r + 100, randColor.g + 100, randColor.b + 100), 
+			button.SetColors(sf::Color(randColor.r + 100, randColor.g + 100, randColor.b + 100), 
 				sf::Color(randColor.r + 50, randColor.g + 50, randColor.b + 50), randColor);
 
-			buttons[i].SetOutline(-5.0f, sf::Color(randColor.r + 10, randColor.g + 10, randColor.b + 10));
+			button.SetOutline(-5.0f, sf::Color(randColor.r + 10, randColor.g + 10, randColor.b + 10));
 
-			buttons[i].ResetColor();
+			button.ResetColor();
 		}
-	
-		gameTitle.setTexture(AssetHolder::Get().GetTexture("gameTitle"));
-		gameTitle.setPosition({ 8.0f, 10.0f });
+		router.Reset();
+		widgets.SetFont(AssetHolder::Get().GetFont(font));
+
+		if (!isTitleBound) {
+			gameTitle.setTexture(AssetHolder::Get().GetTexture(titleTexture));
+			isTitleBound = true;
+		}
+
+		Preload(Play);
 	}
 
-	void Logic() override {}
+	void Logic(float) override {}
 
 	void ManageEvent(sf::Event e, sf::Vector2f mousePos) override {
-		for (auto& button : buttons) {
-			button.Logic(e, mousePos);
-		}
+		int32_t pressed = router.Dispatch(e, mousePos);
+		if (pressed < 0 || e.mouseButton.button != sf::Mouse::Left) return;
 
-		switch (e.type) {
-		case sf::Event::MouseButtonPressed:
-			switch (e.key.code) {
-			case sf::Mouse::Left:
-				for (std::size_t i = 0; i < buttons.size(); i++) {
-					if (buttons[i].IsPositionInBounds(mousePos)) {
-						isStateChanged = true;
-						switch (i) {
-						case 0:
-							state = Play;
-							break;
-						case 1:
-							state = Quit;
-							break;
-						}
-					}
-				}
-				break;
-			}
+		switch (pressed) {
+		case 0:
+			ChangeState(Play);
+			break;
+		case 1:
+			ChangeState(Quit);
 			break;
 		}
 	}
 
-	void Render(sf::RenderWindow& window) override {
-		int index = 0;
-		for (auto& button : buttons) {
-			button.Render(window);
-			RenderText(window, AssetHolder::Get().GetFont("sansationBold"), button.GetPosition().x + buttonSize.x / 2.0f - 30.0f, button.GetPosition().y, buttonNames[index]);
-			index++;
-		}
-	
-		window.draw(gameTitle);
+	void Render(RenderSurface& window) override {
+		widgets.Render(window);
+		window.Draw(gameTitle);
 	}
 };
 
 class PlayState : public GameState {
 private:
-	sf::RectangleShape scoreBox;
-	std::vector<Button> buttons;
-	int index, nSequences, score;
-	bool isColorsRendered;
-	Sound sound;
+	static constexpr uint32_t MaxToneCount = 20; //Four octaves of the pentatonic scale; larger boards reuse them
+
+	WidgetTree widgets;
+	TileBoard board;
+	uint32_t scoreBox;
+	uint32_t lastScore;
+	VoicePool voices; //Binding i plays every tile whose index is i modulo the tone count
+	AssetHandle<sf::Font> font;
+	ToneBank tones;
 	
-	sf::Clock clock;
-	float dt, delay;
-
-	struct VectorIntPair {
-		std::vector<int> vectorInput;
-		std::vector<int> vectorOutput;
+	SequenceGame<Random> game;
+	SequenceGame<Random>::Phase lastPhase;
+	float tickDt; //Length of the ticks Logic is given
 
-		void ClearVectors() {
-			vectorInput.clear();
-			vectorOutput.clear();
-		}
+	void RandomizeTileColors() {
+		for (uint32_t i = 0; i < board.GetTileCount(); i++) {
+			sf::Color randColor = sf::Color(random.Next(100), random.Next(100), random.Next(100));
 
-		void GenerateInputSequence(int n, uint32_t size) {
-			ClearVectors();
-			for (int i = 0; i < n; i++) {
-				vectorInput.push_back(rand() % size);
-			}
+			board.SetColors(i, sf::Color(randColor.r + 100, randColor.g + 100, randColor.b + 100),
+				sf::Color(randColor.r + 50, randColor.g + 50, randColor.b + 50), randColor);
 		}
+		board.ResetColors();
+	}
+public:
+	PlayState(uint64_t seed, uint32_t columns = 2, uint32_t rows = 2)
+		: GameState(seed), board(columns, rows, { 0.0f, 30.0f, 485.0f, 485.0f }), game(board.GetTileCount(), Random(seed, 1)) {
+		font = AssetHolder::Get().GetFontHandle("sansationBold");
+		tones.GenerateAsync(ToneBank::DefaultParams((std::min)(game.GetTileCount(), MaxToneCount)), AssetHolder::Get().GetLoaderPool());
+
+		scoreBox = widgets.Add(-1, { 0.0f, 0.0f }, { 485.0f, 32.0f });
+		lastScore = 0;
+		tickDt = 0.0f;
+	}
 
-		bool IsVectorsEqual() {
-			return vectorInput == vectorOutput;
-		}
-	};
+	void SetScoreText(uint32_t score) {
+		lastScore = score;
+		widgets.SetText(scoreBox, "Score : " + std::to_string(score));
+	}
 
-	VectorIntPair buttonSequences;
+	void OnEnter() override {
+		game.Reset();
+		lastPhase = game.GetPhase();
 
-	void RandomizeButtonColors() {
-		for (int i = 0; i < (int)buttons.size(); i++) {
-			sf::Color randColor = sf::Color(rand() % 100, rand() % 100, rand() % 100);
+		widgets.SetFillColor(scoreBox, sf::Color(random.Next(256), random.Next(256), random.Next(256)));
+		RandomizeTileColors();
 
-			buttons[i].SetColors(sf::Color(randColor.r + 100, randColor.g + 100, randColor.b + 100),
-				sf::Color(randColor.r + 50, randColor.g + 50, randColor.b + 50), randColor);
+		widgets.SetFont(AssetHolder::Get().GetFont(font));
+		SetScoreText(game.GetScore());
 
-			buttons[i].ResetColor();
+		//Without a tone bank the board plays silently
+		if (voices.GetBindingCount() == 0 && tones.Wait()) {
+			for (uint32_t i = 0; i < tones.GetToneCount(); i++) voices.Bind(tones.GetBuffer(i));
 		}
 	}
-public:
-	PlayState() {
-		LoadAssets();
 
-		index = score = 0;
-		dt = 0.0f;
-		delay = 1.0f;
-		isColorsRendered = false; //Is Color Sequence shown
-		nSequences = 1;
+	void OnPause() override {
+		voices.PauseAll();
+	}
+
+	void OnResume() override {
+		voices.ResumeAll();
+	}
+
+	void OnExit() override {
+		voices.StopAll();
+	}
 
-		scoreBox.setSize({ 485.0f, 32.0f });
-		scoreBox.setPosition({ 0.0f, 0.0f });
-		scoreBox.setFillColor(sf::Color(rand() % 256, rand() % 256, rand() % 256));
+	void Logic(float frameDt) override {
+		tickDt = frameDt;
+		if (game.Advance(frameDt)) RandomizeTileColors();
+	}
 
-		int pos = 0;
-		for (int i = 0; i < 4; i++) {
-			buttons.push_back(Button());
-			buttons[i].Initialize({ (i % 2) * 235.0f + 15.0f, pos * 235.0f + 45.0f }, { 220.0f, 220.0f });
+	//Shows the sequence as of ahead seconds after the last tick
+	void UpdateTileColors(float ahead) {
+		using Phase = SequenceGame<Random>::Phase;
 
-			buttons[i].ResetColor();
+		Phase phase = game.GetPhase();
+		if (phase != Phase::Input || lastPhase != Phase::Input) board.SetAllFillColors(TileBoard::MouseRelease);
+		lastPhase = phase;
 
-			if (i == 1) pos++;
+		switch (phase) {
+		case Phase::ShowSequence: {
+			int n = game.GetLitTile(ahead);
+			if (n >= 0) board.SetFillColor(n, board.GetColors(TileBoard::MousePressed)[n]);
+			break;
+		}
+		case Phase::Success:
+			if (game.IsFlashOn(ahead)) board.SetAllFillColors(TileBoard::MousePressed);
+			break;
+		case Phase::Failure:
+			if (game.IsFlashOn(ahead)) board.SetAllFillColors(sf::Color::Red);
+			break;
+		default:
+			break;
 		}
-		RandomizeButtonColors();
-
-		buttonSequences.GenerateInputSequence(nSequences, buttons.size());
 	}
 
-	void ResetButtonColors() {
-		for (auto& button : buttons) {
-			button.SetFillColor(button.GetColors()[Button::ButtonState::MouseRelease]);
+	void ManageEvent(sf::Event e, sf::Vector2f mousePos) override {
+		std::chrono::steady_clock::time_point eventTime = std::chrono::steady_clock::now();
+		int32_t pressed = board.ManageEvent(e, mousePos);
+
+		switch (e.type) {
+		case sf::Event::MouseButtonPressed:
+			if (pressed >= 0 && game.GetPhase() == SequenceGame<Random>::Phase::Input) {
+				if (voices.GetBindingCount()) {
+					voices.Play((uint32_t)(pressed % voices.GetBindingCount()), eventTime);
+					PROFILE_COUNTER("trigger avg us", voices.GetLatencyStats().averageMicroseconds);
+					PROFILE_COUNTER("trigger max us", voices.GetLatencyStats().maxMicroseconds);
+				}
+
+				game.Press((uint32_t)pressed);
+			}
+			break;
+		case sf::Event::KeyPressed:
+			switch (e.key.code) {
+			case sf::Keyboard::Escape:
+				board.ResetColors();
+				ChangeState(Pause, Push);
+				break;
+			}
+			break;
 		}
 	}
 
-	void Logic() override {
+	void Render(RenderSurface& window) override {
+		if (game.GetScore() != lastScore) SetScoreText(game.GetScore());
+		UpdateTileColors(interpolation * tickDt);
+		board.Render(window);
+		widgets.Render(window);
+	}
+}; 
 
-		float frameDt = (float)clock.getElapsedTime().asSeconds();
-		clock.restart();
+class PauseState : public GameState {
+private:
+	WidgetTree widgets;
+	std::vector<RetainedButton> buttons;
+	sf::Vector2f buttonSize;
 
-		if (!isColorsRendered) {
-			if (buttonSequences.vectorInput.size() > 0) {
+	const std::string buttonNames[2] = { "Resume", "Menu" };
+	AssetHandle<sf::Font> font;
+	UIRouter router;
+public:
+	PauseState(uint64_t seed)
+		: GameState(seed), router({ 0.0f, 0.0f, 485.0f, 515.0f }) {
+		font = AssetHolder::Get().GetFontHandle("sansationBold");
 
-				dt += frameDt;
+		uint32_t shade = widgets.Add(-1, { 0.0f, 0.0f }, { 485.0f, 515.0f }, sf::Color(0, 0, 0, 160));
+		uint32_t title = widgets.Add((int32_t)shade, { 142.25f, 140.0f }, { 200.0f, 50.0f });
+		widgets.SetText(title, "Paused");
 
-				ResetButtonColors();
-				int n = buttonSequences.vectorInput[index];
-				if (((int)dt % 2) != 0) buttons[n].SetFillColor(buttons[n].GetColors()[Button::ButtonState::MousePressed]);
+		buttonSize = { 200.0f, 50.0f };
 
-				if (dt > 2 * delay) {
-					index++;
-					if (index > (nSequences - 1)) {
-						index = 0;
-						isColorsRendered = true;
-						ResetButtonColors();
-					}
-					dt = 0.0f;
-				}
-			}
+		buttons.resize(2);
+		for (int i = 0; i < 2; i++) {
+			buttons[i].Initialize(widgets, { 142.25f, 220.0f + (i * (buttonSize.y + 10.0f)) }, buttonSize, (int32_t)shade);
+			buttons[i].SetLabel(buttonNames[i]);
+			buttons[i].SetColors(sf::Color(170, 170, 170), sf::Color(120, 120, 120), sf::Color(70, 70, 70));
+			buttons[i].SetOutline(-5.0f, sf::Color(40, 40, 40));
+			router.Add(&buttons[i], buttons[i].GetBounds());
 		}
-		else {
-			if (buttonSequences.IsVectorsEqual()) {
-				dt += frameDt;
-
-				ResetButtonColors();
-				if (((int)dt % 2) != 0) {
-					for (auto& button : buttons) {
-						button.SetFillColor(button.GetColors()[Button::ButtonState::MousePressed]);
-					}
-				}
+	}
 
-				if (dt > 2 * delay) {
-					isColorsRendered = false;
-					dt = 0.0f;
-					nSequences++;
-					RandomizeButtonColors();
-					buttonSequences.GenerateInputSequence(nSequences, buttons.size());
-					score++;
-				}
-			}
-			else {
-				if (buttonSequences.vectorOutput.size() > buttonSequences.vectorInput.size()) {
-
-					dt += frameDt;
-					
-					ResetButtonColors();
-					if (((int)dt % 2) != 0) {
-						for (auto& button : buttons) {
-							button.SetFillColor(sf::Color::Red);
-						}
-					}
+	bool IsOverlay() const override { return true; }
 
-					if (dt > 2 * delay) {
-						isColorsRendered = false;
-						dt = 0.0f;
-						RandomizeButtonColors();
-						buttonSequences.GenerateInputSequence(nSequences, buttons.size());
-					}
-				}
-			}
+	void OnEnter() override {
+		for (auto& button : buttons) {
+			button.ResetColor();
 		}
+		router.Reset();
+		widgets.SetFont(AssetHolder::Get().GetFont(font));
 	}
 
+	void Logic(float) override {}
+
 	void ManageEvent(sf::Event e, sf::Vector2f mousePos) override {
-		for (auto& button : buttons) {
-			button.Logic(e, mousePos);
-		}
+		int32_t pressed = router.Dispatch(e, mousePos);
 
 		switch (e.type) {
 		case sf::Event::MouseButtonPressed:
-			switch (e.key.code) {
-			case sf::Mouse::Left:
-				if (isColorsRendered) {
-					for (std::size_t i = 0; i < buttons.size(); i++) {
-						if (buttons[i].IsPositionInBounds(mousePos)) {
-
-							switch (i) {
-							case 0:
-								sound.setBuffer(AssetHolder::Get().GetSoundBuffer("beep1"));
-								break;
-							case 1:
-								sound.setBuffer(AssetHolder::Get().GetSoundBuffer("beep2"));
-								break;
-							case 2:
-								sound.setBuffer(AssetHolder::Get().GetSoundBuffer("beep3"));
-								break;
-							case 3:
-								sound.setBuffer(AssetHolder::Get().GetSoundBuffer("beep4"));
-								break;
-							}
-
-							sound.play();
-
-							buttonSequences.vectorOutput.push_back(i);
-							break;
-						}
-					}
-				}
-				break;
-			}
+			if (pressed < 0 || e.mouseButton.button != sf::Mouse::Left) break;
+
+			if (pressed == 0) ChangeState(Play, Pop);
+			else ChangeState(Menu);
 			break;
 		case sf::Event::KeyPressed:
 			switch (e.key.code) {
 			case sf::Keyboard::Escape:
-				state = Menu;
-				isStateChanged = true;
+				ChangeState(Play, Pop);
 				break;
 			}
 			break;
 		}
 	}
 
-	void Render(sf::RenderWindow& window) override {
-		for (auto& button : buttons) {
-			button.Render(window);
+	void Render(RenderSurface& window) override {
+		widgets.Render(window);
+	}
+};
+
+//Registry of the states, each created once on first use and kept alive, plus the stack of the ones
+//currently open. Switching, pushing and popping only run OnEnter/OnExit, so no state is rebuilt
+class StateStack {
+private:
+	using Factory = std::function<std::unique_ptr<GameState>(uint64_t)>;
+
+	std::unique_ptr<GameState> states[GameState::StateCount];
+	Factory factories[GameState::StateCount];
+	std::vector<GameState*> stack;
+	Random random;
+
+	GameState& Acquire(GameState::State id) {
+		if (!states[id]) states[id] = factories[id](random.Next64());
+		return *states[id];
+	}
+public:
+	StateStack(uint64_t seed)
+		: random(seed) {
+		stack.reserve(GameState::StateCount);
+	}
+
+	//args are passed to the constructor of T after the seed
+	template<typename T, typename... Args>
+	void Register(GameState::State id, Args... args) {
+		factories[id] = [args...](uint64_t seed) -> std::unique_ptr<GameState> { return std::make_unique<T>(seed, args...); };
+	}
+
+	//Closes and destroys every state; they are created again from the new seed
+	void Reset(uint64_t seed) {
+		Clear();
+		for (auto& state : states) state.reset();
+		random.Seed(seed);
+	}
+
+	void Preload(GameState::State id) {
+		Acquire(id);
+	}
+
+	void Push(GameState::State id) {
+		GameState& state = Acquire(id);
+		if (!stack.empty()) stack.back()->OnPause();
+		stack.push_back(&state);
+		state.OnEnter();
+	}
+
+	void Pop() {
+		stack.back()->OnExit();
+		stack.pop_back();
+		if (!stack.empty()) stack.back()->OnResume();
+	}
+
+	//Exits every state from the top down without resuming the covered ones
+	void Clear() {
+		while (!stack.empty()) {
+			stack.back()->OnExit();
+			stack.pop_back();
 		}
+	}
 
-		window.draw(scoreBox);
-		DrawTextWithValue(window, AssetHolder::Get().GetFont("sansationBold"), 0.0f, 0.0f, "Score : ", score);
+	void Switch(GameState::State id) {
+		Clear();
+		Push(id);
 	}
-}; 
+
+	GameState& Top() { return *stack.back(); }
+
+	//Applies the preload and transition the top state asked for. Returns false once it asks to quit
+	bool Update() {
+		GameState& top = Top();
+
+		if (top.isPreloadRequested) {
+			top.isPreloadRequested = false;
+			Preload(top.preloadState);
+		}
+
+		if (!top.isStateChanged) return true;
+		top.isStateChanged = false;
+
+		if (top.state == GameState::Quit) return false;
+
+		switch (top.transition) {
+		case GameState::Switch:
+			Switch(top.state);
+			break;
+		case GameState::Push:
+			Push(top.state);
+			break;
+		case GameState::Pop:
+			if (stack.size() > 1) Pop();
+			break;
+		}
+		return true;
+	}
+
+	//Draws from the topmost non-overlay state up
+	void Render(RenderSurface& window) {
+		std::size_t first = stack.size() - 1;
+		while (first > 0 && stack[first]->IsOverlay()) first--;
+
+		for (std::size_t i = first; i < stack.size(); i++) {
+			stack[i]->Render(window);
+		}
+	}
+};
 
 class Game {
 private:
 	sf::RenderWindow Window;
+	WindowSurface surface; //What the states draw to; a SoftwareSurface takes the same calls
 	sf::Vector2u windowSize;
+	sf::Vector2u boardSize; //Tile columns and rows of the play state
+
+	StateStack states;
+
+	uint32_t tickRate;
+	float tickDt;
+	uint32_t maxTicksPerFrame;
+
+	uint64_t seed;
+	Random random; //Only hands out seeds, so a run is reproduced from the seed passed to Game
+
+	InputRecorder recorder;
 
-	std::unique_ptr<GameState> gameState;
+#if PROFILER_ENABLED
+	ProfilerOverlay profilerOverlay;
+	AssetHandle<sf::Font> overlayFont;
+	bool isProfilerShown = false;
+#endif
+
+	void SwitchState() {
+		if (!states.Update()) Window.close();
+	}
+
+	void Present() {
+		Window.clear();
+		{
+			PROFILE_ZONE("GameState::Render");
+			states.Render(surface);
+		}
+
+#if PROFILER_ENABLED
+		if (isProfilerShown) profilerOverlay.Render(surface, AssetHolder::Get().GetFont(overlayFont));
+#endif
+		Window.display();
+	}
 public:
-	Game(const sf::Vector2u size, const sf::String& title)
+	Game(const sf::Vector2u size, const sf::String& title, uint64_t seed, const sf::Vector2u boardSize = { 2, 2 }, uint32_t tickRate = 120, uint32_t maxTicksPerFrame = 8)
 		: Window({ size.x, size.y }, title),
-		  windowSize(size) {
+		  surface(Window),
+		  windowSize(size),
+		  boardSize(boardSize),
+		  states(0),
+		  tickRate(tickRate),
+		  tickDt(1.0f / tickRate),
+		  maxTicksPerFrame(maxTicksPerFrame),
+		  seed(seed),
+		  random(seed) {
 		Window.setFramerateLimit(60);
 
-		gameState = std::make_unique<MenuState>();
+		GameState::LoadAssets();
+
+		states.Register<MenuState>(GameState::Menu);
+		states.Register<PlayState>(GameState::Play, boardSize.x, boardSize.y);
+		states.Register<PauseState>(GameState::Pause);
+		states.Reset(random.Next64());
+		states.Switch(GameState::Menu);
+
+#if PROFILER_ENABLED
+		overlayFont = AssetHolder::Get().GetFontHandle("sansationBold");
+#endif
 	}
 
 	void Run() {
 		Logic();
 	}
 
+	//Journals every event and the tick count of every frame, together with the seed, tick rate and board size
+	bool StartRecording(const std::string& filepath) {
+		return recorder.Open(filepath, seed, tickRate, boardSize.x, boardSize.y);
+	}
+
+	//Simulation advances in fixed tickDt steps independent of the presentation rate. After a long
+	//hitch at most maxTicksPerFrame ticks are run and the remaining backlog is dropped
 	void Logic() {
+		sf::Clock clock;
+		float accumulator = 0.0f;
+
 		while (Window.isOpen()) {
 			sf::Event event;
 
 			sf::Vector2f mousePos = (sf::Vector2f)sf::Mouse::getPosition(Window);
 
-			if (gameState->isStateChanged) {
-				if (gameState->state == GameState::State::Play) gameState = std::make_unique<PlayState>();
-				else if (gameState->state == GameState::State::Menu) gameState = std::make_unique<MenuState>();
-				else if (gameState->state == GameState::State::Quit) Window.close();
-				gameState->isStateChanged = false;
+			SwitchState();
+
+			{
+				PROFILE_ZONE("Game::PollEvents");
+				while (Window.pollEvent(event)) {
+					switch (event.type) {
+					case sf::Event::Closed:
+						Window.close();
+						break;
+#if PROFILER_ENABLED
+					case sf::Event::KeyPressed:
+						if (event.key.code == sf::Keyboard::F3) isProfilerShown = !isProfilerShown;
+						break;
+#endif
+					}
+				
+					if (recorder.IsOpen()) recorder.RecordEvent(event, mousePos);
+					states.Top().ManageEvent(event, mousePos);
+				}
 			}
 
-			while (Window.pollEvent(event)) {
-				switch (event.type) {
-				case sf::Event::Closed:
-					Window.close();
-					break;
-				}
-			
-				gameState->ManageEvent(event, mousePos);
+			accumulator += clock.restart().asSeconds();
+
+			uint32_t nTicks = 0;
+			while (accumulator >= tickDt && nTicks < maxTicksPerFrame) {
+				PROFILE_ZONE("GameState::Logic");
+				states.Top().Logic(tickDt);
+				accumulator -= tickDt;
+				nTicks++;
 			}
+			if (nTicks == maxTicksPerFrame && accumulator >= tickDt) accumulator = 0.0f;
 
-			gameState->Logic();
+			if (recorder.IsOpen()) recorder.RecordFrame(nTicks);
 
-			Window.clear();
-			gameState->Render(Window);
-			Window.display();
+			states.Top().interpolation = accumulator / tickDt;
+
+			Present();
+			PROFILE_END_FRAME();
 		}
+
+		recorder.Close();
+	}
+
+	//Feeds a journal back through the states frame by frame without waiting for real time.
+	//Rendering is optional, so a replay runs as fast as the simulation allows
+	bool Replay(const std::string& filepath, bool isRendered = false) {
+		InputJournalReader reader;
+		if (!reader.Open(filepath)) {
+			std::cout << "Couldn't load the journal " << filepath << std::endl;
+			return false;
+		}
+
+		seed = reader.GetSeed();
+		random.Seed(seed);
+		boardSize = { reader.GetBoardColumns(), reader.GetBoardRows() };
+		states.Register<PlayState>(GameState::Play, boardSize.x, boardSize.y);
+		states.Reset(random.Next64());
+		states.Switch(GameState::Menu);
+
+		float replayDt = 1.0f / reader.GetTickRate();
+		Window.setFramerateLimit(0);
+
+		JournalEntry entry;
+		while (Window.isOpen() && reader.Next(entry)) {
+			if (entry.type == JournalEntry::Event) {
+				states.Top().ManageEvent(entry.event, entry.mousePos);
+				continue;
+			}
+
+			for (uint32_t i = 0; i < entry.nTicks; i++) {
+				states.Top().Logic(replayDt);
+			}
+
+			if (isRendered) {
+				states.Top().interpolation = 0.0f; //The journal's ticks were all run
+				Present();
+			}
+
+			SwitchState();
+		}
+
+		return true;
 	}
 };
 
-int main() {
+int main(int argc, char** argv) {
+
+	uint64_t seed = (uint64_t)time(0);
+	std::string recordPath, replayPath;
+	std::string tracePath;
+	bool isReplayRendered = false;
+	sf::Vector2u boardSize = { 2, 2 };
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--seed" && i + 1 < argc) {
+			const char* value = argv[++i];
+			const char* end = value + std::strlen(value);
+			std::from_chars_result result = std::from_chars(value, end, seed);
+			if (result.ec != std::errc() || result.ptr != end) {
+				std::cout << "--seed takes an unsigned 64-bit integer" << std::endl;
+				return 1;
+			}
+		}
+		else if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+		else if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+		else if (arg == "--replay-render") isReplayRendered = true;
+		else if (arg == "--trace" && i + 1 < argc) {
+			tracePath = argv[++i];
+#if !PROFILER_ENABLED
+			std::cout << "--trace is ignored: this build has the profiler off (PROFILER_ENABLED)" << std::endl;
+#endif
+		}
+		else if (arg == "--board" && i + 1 < argc) {
+			uint32_t columns = 0, rows = 0;
+			if (std::sscanf(argv[++i], "%ux%u", &columns, &rows) != 2 || columns == 0 || rows == 0 || columns > TileBoard::MaxColumns || rows > TileBoard::MaxRows || columns * rows < 2) {
+				std::cout << "--board takes COLUMNSxROWS, from 1x2 up to " << TileBoard::MaxColumns << "x" << TileBoard::MaxRows << std::endl;
+				return 1;
+			}
+			boardSize = { columns, rows };
+		}
+	}
+
+	Game game({ 485, 515 }, "Game", seed, boardSize);
 
-	srand((unsigned)time(0));
+	if (!replayPath.empty()) return game.Replay(replayPath, isReplayRendered) ? 0 : 1;
 
-	Game game({ 485, 515 }, "Game");
+	if (!recordPath.empty() && !game.StartRecording(recordPath)) {
+		std::cout << "Couldn't record to " << recordPath << std::endl;
+	}
 	game.Run();
 
+#if PROFILER_ENABLED
+	if (!tracePath.empty() && !Profiler::Get().ExportChromeTrace(tracePath)) {
+		std::cout << "Couldn't write the trace to " << tracePath << std::endl;
+	}
+#endif
+
 	return 0;
 }
\ No newline at end of file
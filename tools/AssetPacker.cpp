@@ -0,0 +1,65 @@
+// Packs every file under the given directories into one indexed archive read by AssetArchive.
+// Run from the game's working directory so the packed names match the paths used in LoadAssets:
+//   AssetPacker files/assets.pak files/images files/sounds files/fonts
+#include "../AssetArchive.h"
+#include <filesystem>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+void PrintUsage(const char* program) {
+	std::cout << "Usage: " << program << " <archive> <directory>..." << std::endl;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> files;
+	uint64_t totalSize = 0;
+
+	for (int i = 2; i < argc; i++) {
+		std::error_code error;
+		if (!fs::is_directory(argv[i], error)) {
+			std::cout << argv[i] << " is not a directory" << std::endl;
+			PrintUsage(argv[0]);
+			return 1;
+		}
+
+		for (fs::recursive_directory_iterator it(argv[i], error), end; !error && it != end; it.increment(error)) {
+			if (!it->is_regular_file(error)) continue;
+
+			const fs::directory_entry& entry = *it;
+			std::ifstream reader(entry.path(), std::ios::binary);
+			if (!reader.is_open()) {
+				std::cout << "Couldn't read " << entry.path().generic_string() << std::endl;
+				return 1;
+			}
+
+			std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(reader)), std::istreambuf_iterator<char>());
+			totalSize += bytes.size();
+			files.emplace_back(entry.path().lexically_normal().generic_string(), std::move(bytes));
+		}
+
+		if (error) {
+			std::cout << "Couldn't list " << argv[i] << ": " << error.message() << std::endl;
+			return 1;
+		}
+	}
+
+	if (!AssetArchive::Write(argv[1], files)) {
+		std::cout << "Couldn't write " << argv[1] << std::endl;
+		return 1;
+	}
+
+	AssetArchive archive;
+	if (!archive.Open(argv[1]) || archive.GetEntryCount() != files.size()) {
+		std::cout << "Verification of " << argv[1] << " failed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Packed " << files.size() << " files (" << totalSize << " bytes) into " << argv[1] << std::endl;
+	return 0;
+}
@@ -0,0 +1,190 @@
+// Plays the memory game headlessly with simulated players and reports score statistics.
+// Every game draws from its own random streams derived from the seed and the game index,
+// so results do not depend on the thread count or on scheduling:
+//   BatchRunner --games 1000000 --seed 42 --error-base 0.01 --error-slope 0.01
+#include "../SequenceGame.h"
+#include "../Random.h"
+#include "../ThreadPool.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstring>
+#include <chrono>
+
+struct PlayerModel {
+	double errorBase = 0.0; //Chance to press a wrong tile, for any sequence length
+	double errorPerLength = 0.01; //Added to errorBase for every tile in the sequence
+	double reactionMean = 0.35; //Seconds between presses
+	double reactionStdDev = 0.1;
+};
+
+struct BatchOptions {
+	uint64_t nGames = 100000;
+	uint64_t seed = 1;
+	uint32_t nThreads = 0;
+	uint32_t nTiles = 4;
+	uint32_t nLives = 3;
+	uint32_t maxRounds = 200;
+	float delay = 1.0f;
+	float tick = 0.5f;
+	std::size_t grain = 256;
+	PlayerModel player;
+};
+
+struct GameResult {
+	uint32_t score;
+	uint64_t durationMs;
+	uint64_t nPresses;
+};
+
+// One game ends after nLives failed rounds or after maxRounds successful ones
+GameResult SimulateGame(const BatchOptions& options, uint64_t gameIndex) {
+	using Game = SequenceGame<Random>;
+
+	Game game(options.nTiles, Random(options.seed, gameIndex * 2), options.delay);
+	Random player(options.seed, gameIndex * 2 + 1);
+
+	const PlayerModel& model = options.player;
+	uint32_t failures = 0;
+	uint64_t nPresses = 0;
+	double time = 0.0;
+
+	while (failures < options.nLives && game.GetScore() < options.maxRounds) {
+		if (game.GetPhase() != Game::Input) {
+			game.Advance(options.tick);
+			time += options.tick;
+			continue;
+		}
+
+		uint32_t length = game.GetSequenceLength();
+		uint32_t tile = game.GetSequence()[game.GetInputCount()];
+
+		if (player.NextDouble() < model.errorBase + model.errorPerLength * length) {
+			tile = (tile + 1 + player.Next(options.nTiles - 1)) % options.nTiles;
+		}
+
+		nPresses++;
+		time += (std::max)(0.05, player.NextNormal(model.reactionMean, model.reactionStdDev));
+
+		if (game.Press(tile) == Game::Mistake) failures++;
+	}
+
+	return { game.GetScore(), (uint64_t)(time * 1000.0), nPresses };
+}
+
+struct BatchStatistics {
+	std::vector<uint64_t> scoreHistogram;
+	uint64_t totalDurationMs = 0;
+	uint64_t totalPresses = 0;
+
+	void Merge(const BatchStatistics& other) {
+		for (std::size_t i = 0; i < scoreHistogram.size(); i++) {
+			scoreHistogram[i] += other.scoreHistogram[i];
+		}
+		totalDurationMs += other.totalDurationMs;
+		totalPresses += other.totalPresses;
+	}
+};
+
+uint32_t Percentile(const std::vector<uint64_t>& histogram, uint64_t nGames, double fraction) {
+	uint64_t target = (uint64_t)(fraction * (nGames - 1));
+	uint64_t seen = 0;
+
+	for (uint32_t score = 0; score < histogram.size(); score++) {
+		seen += histogram[score];
+		if (seen > target) return score;
+	}
+
+	return (uint32_t)histogram.size() - 1;
+}
+
+bool ParseArguments(int argc, char** argv, BatchOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string name = argv[i];
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << name << std::endl;
+			return false;
+		}
+
+		const char* value = argv[++i];
+		if (name == "--games") options.nGames = std::stoull(value);
+		else if (name == "--seed") options.seed = std::stoull(value);
+		else if (name == "--threads") options.nThreads = (uint32_t)std::stoul(value);
+		else if (name == "--tiles") options.nTiles = (uint32_t)std::stoul(value);
+		else if (name == "--lives") options.nLives = (uint32_t)std::stoul(value);
+		else if (name == "--max-rounds") options.maxRounds = (uint32_t)std::stoul(value);
+		else if (name == "--delay") options.delay = std::stof(value);
+		else if (name == "--tick") options.tick = std::stof(value);
+		else if (name == "--grain") options.grain = std::stoull(value);
+		else if (name == "--error-base") options.player.errorBase = std::stod(value);
+		else if (name == "--error-slope") options.player.errorPerLength = std::stod(value);
+		else if (name == "--reaction-mean") options.player.reactionMean = std::stod(value);
+		else if (name == "--reaction-sd") options.player.reactionStdDev = std::stod(value);
+		else {
+			std::cout << "Unknown option " << name << std::endl;
+			return false;
+		}
+	}
+
+	if (options.nTiles < 2 || options.nTiles > SequenceGame<>::MaxTileCount || options.nLives == 0 || options.tick <= 0.0f || options.nGames == 0) {
+		std::cout << "Need 2-" << SequenceGame<>::MaxTileCount << " tiles, at least one life, one game and a positive tick" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv) {
+	BatchOptions options;
+	if (!ParseArguments(argc, argv, options)) return 1;
+
+	ThreadPool pool(options.nThreads ? options.nThreads : (std::max)(1u, std::thread::hardware_concurrency()));
+
+	std::vector<BatchStatistics> slots(pool.GetThreadCount());
+	for (auto& slot : slots) {
+		slot.scoreHistogram.assign(options.maxRounds + 1, 0);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	pool.ParallelFor(options.nGames, options.grain, [&options, &slots](std::size_t begin, std::size_t end, uint32_t slot) {
+		BatchStatistics& statistics = slots[slot];
+		for (std::size_t i = begin; i < end; i++) {
+			GameResult result = SimulateGame(options, i);
+			statistics.scoreHistogram[result.score]++;
+			statistics.totalDurationMs += result.durationMs;
+			statistics.totalPresses += result.nPresses;
+		}
+	});
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	BatchStatistics total = slots[0];
+	for (std::size_t i = 1; i < slots.size(); i++) {
+		total.Merge(slots[i]);
+	}
+
+	uint64_t scoreSum = 0, scoreSquareSum = 0;
+	for (uint32_t score = 0; score < total.scoreHistogram.size(); score++) {
+		scoreSum += total.scoreHistogram[score] * score;
+		scoreSquareSum += total.scoreHistogram[score] * score * score;
+	}
+
+	double mean = (double)scoreSum / options.nGames;
+	double variance = (double)scoreSquareSum / options.nGames - mean * mean;
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "games        " << options.nGames << " (seed " << options.seed << ", " << options.nTiles << " tiles, " << options.nLives << " lives)" << std::endl;
+	std::cout << "score mean   " << mean << "  stddev " << std::sqrt((std::max)(variance, 0.0)) << std::endl;
+	std::cout << "score p10/50/90/99  " << Percentile(total.scoreHistogram, options.nGames, 0.10) << " / " << Percentile(total.scoreHistogram, options.nGames, 0.50) << " / "
+		<< Percentile(total.scoreHistogram, options.nGames, 0.90) << " / " << Percentile(total.scoreHistogram, options.nGames, 0.99) << std::endl;
+	std::cout << "game length  " << (double)total.totalDurationMs / options.nGames / 1000.0 << " s simulated, " << (double)total.totalPresses / options.nGames << " presses" << std::endl;
+
+	std::cout << "histogram" << std::endl;
+	for (uint32_t score = 0; score < total.scoreHistogram.size(); score++) {
+		if (total.scoreHistogram[score]) std::cout << "  " << std::setw(4) << score << "  " << total.scoreHistogram[score] << std::endl;
+	}
+
+	std::cout << "throughput   " << std::setprecision(0) << options.nGames / seconds << " games/s on " << pool.GetThreadCount() << " threads (" << std::setprecision(3) << seconds << " s)" << std::endl;
+	return 0;
+}
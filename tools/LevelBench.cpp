@@ -0,0 +1,83 @@
+// Times Level::LoadLevel on a large map in the text and binary formats. Load each file in its own
+// process so the peak resident size is that of the load alone:
+//   LevelBench --write levels 4096                 writes levels/bench.txt and levels/bench.lvl, 4096x4096
+//   LevelBench --load levels/bench.txt
+//   LevelBench --load levels/bench.lvl [--no-verify]
+#include "../GraphicsRender.h"
+#include "../Random.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <chrono>
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+// Peak resident set size of the process in MB, or 0 where it is not available
+double GetPeakMemory() {
+#if defined(_WIN32)
+	return 0.0;
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+	return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+	return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+bool WriteLevels(const std::string& directory, uint32_t size) {
+	const char tiles[] = ".#@ox";
+	Random random(1);
+
+	TileGrid grid(size, size, '.');
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) grid.At(x, y) = tiles[random.Next(sizeof(tiles) - 1)];
+	}
+	Level level(std::move(grid));
+
+	std::ofstream writer(directory + "/bench.txt");
+	for (uint32_t y = 0; y < size; y++) writer << level.GetRow(y) << "\n";
+	writer.close();
+
+	if (!writer || !level.SaveLevelBinary(directory + "/bench.lvl")) {
+		std::cout << "Couldn't write the levels to " << directory << std::endl;
+		return false;
+	}
+
+	std::cout << "wrote " << directory << "/bench.txt and " << directory << "/bench.lvl, " << size << "x" << size << std::endl;
+	return true;
+}
+
+bool LoadLevel(const std::string& filepath, bool verifyChecksum) {
+	auto start = std::chrono::steady_clock::now();
+	Level level = Level::LoadLevel(filepath, verifyChecksum);
+	double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	if (level.GetWidth() == 0) return false;
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << filepath << (verifyChecksum ? "" : " (no verify)") << ": " << level.GetWidth() << "x" << level.GetHeight()
+		<< " in " << elapsed << " ms, peak " << GetPeakMemory() << " MB" << std::endl;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	std::string mode = argc > 2 ? argv[1] : "";
+
+	if (mode == "--write") {
+		uint32_t size = argc > 3 ? (uint32_t)std::strtoul(argv[3], nullptr, 10) : 4096;
+		return size > 0 && WriteLevels(argv[2], size) ? 0 : 1;
+	}
+
+	if (mode == "--load") {
+		bool verifyChecksum = !(argc > 3 && std::string(argv[3]) == "--no-verify");
+		return LoadLevel(argv[2], verifyChecksum) ? 0 : 1;
+	}
+
+	std::cout << "Usage: LevelBench --write DIR [SIZE] | --load FILE [--no-verify]" << std::endl;
+	return 1;
+}
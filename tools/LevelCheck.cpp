@@ -0,0 +1,187 @@
+// Checks that levels edited through ChunkedLevel load again through Level::LoadLevel with the checksum
+// verified, and that corrupt headers are refused. Needs the SFML headers only; writes to the temp directory:
+//   LevelCheck
+#include "../ChunkedLevel.h"
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct CheckContext {
+	fs::path directory;
+	uint32_t nFailed = 0, nChecks = 0;
+
+	void Report(const char* name, bool isPassed, const std::string& message = "") {
+		nChecks++;
+		if (isPassed) {
+			std::cout << "ok     " << name << std::endl;
+			return;
+		}
+
+		nFailed++;
+		std::cout << "FAIL   " << name << ": " << message << std::endl;
+	}
+};
+
+// A w x h level of '.' with a '#' border
+Level MakeLevel(uint32_t w, uint32_t h) {
+	TileGrid grid(w, h, '.');
+	for (uint32_t y = 0; y < h; y++) {
+		for (uint32_t x = 0; x < w; x++) {
+			if (x == 0 || y == 0 || x == w - 1 || y == h - 1) grid.At(x, y) = '#';
+		}
+	}
+	return Level(std::move(grid));
+}
+
+// Empty when every tile of the loaded level matches the expected one
+std::string Compare(const Level& loaded, const Level& expected) {
+	if (loaded.GetWidth() != expected.GetWidth() || loaded.GetHeight() != expected.GetHeight()) {
+		return "loaded " + std::to_string(loaded.GetWidth()) + "x" + std::to_string(loaded.GetHeight());
+	}
+
+	for (uint32_t y = 0; y < expected.GetHeight(); y++) {
+		if (loaded.GetRow(y) != expected.GetRow(y)) return "row " + std::to_string(y) + " differs";
+	}
+	return "";
+}
+
+LevelHeader ReadHeader(const fs::path& path) {
+	LevelHeader header = {};
+	std::ifstream reader(path, std::ios::binary);
+	reader.read(reinterpret_cast<char*>(&header), sizeof(header));
+	return header;
+}
+
+void WriteHeader(const fs::path& path, const LevelHeader& header) {
+	std::fstream writer(path, std::ios::in | std::ios::out | std::ios::binary);
+	writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+// Edits in resident chunks, flushed explicitly, including a character the palette did not have
+void CheckFlush(CheckContext& context) {
+	fs::path path = context.directory / "flush.lvl";
+	Level expected = MakeLevel(300, 200);
+	expected.SaveLevelBinary(path.string());
+
+	{
+		ChunkedLevel chunked(64, 64);
+		chunked.OpenBinary(path.string());
+		for (int i = 0; i < 150; i++) {
+			chunked.SetTile(i * 2, i, 'x');
+			expected.SetTile(i * 2, i, 'x');
+		}
+		context.Report("flush returns", chunked.Flush(), "Flush failed");
+	}
+
+	Level loaded = Level::LoadLevel(path.string(), true);
+	std::string difference = Compare(loaded, expected);
+	context.Report("flush reloads", difference.empty(), difference);
+	context.Report("flush palette", loaded.GetPalette() == "#.x", "palette is \"" + loaded.GetPalette() + "\"");
+}
+
+// Edits written back when their chunk is evicted, then the header brought up to date by the destructor
+void CheckEviction(CheckContext& context) {
+	fs::path path = context.directory / "evict.lvl";
+	Level expected = MakeLevel(256, 256);
+	expected.SaveLevelBinary(path.string());
+
+	{
+		ChunkedLevel chunked(32, 2);
+		chunked.OpenBinary(path.string());
+		for (int y = 0; y < 256; y += 7) {
+			for (int x = 0; x < 256; x += 13) {
+				chunked.SetTile(x, y, 'o');
+				expected.SetTile(x, y, 'o');
+			}
+		}
+	}
+
+	Level loaded = Level::LoadLevel(path.string(), true);
+	std::string difference = Compare(loaded, expected);
+	context.Report("evicted edits reload", difference.empty(), difference);
+}
+
+// A palette that no longer fits before the payload moves the payload
+void CheckPaletteGrowth(CheckContext& context) {
+	fs::path path = context.directory / "palette.lvl";
+	Level expected = MakeLevel(100, 100);
+	for (uint32_t i = 0; i < 30; i++) expected.SetTile(1 + i, 1, (char)('A' + i));
+	expected.SaveLevelBinary(path.string());
+	uint64_t oldOffset = ReadHeader(path).payloadOffset;
+
+	{
+		ChunkedLevel chunked(16, 4);
+		chunked.OpenBinary(path.string());
+		for (uint32_t i = 0; i < 40; i++) {
+			chunked.SetTile(1 + i, 2, (char)('a' + i % 26 + (i >= 26 ? 128 : 0)));
+			expected.SetTile(1 + i, 2, (char)('a' + i % 26 + (i >= 26 ? 128 : 0)));
+		}
+		context.Report("palette growth flushes", chunked.Flush(), "Flush failed");
+	}
+
+	Level loaded = Level::LoadLevel(path.string(), true);
+	std::string difference = Compare(loaded, expected);
+	context.Report("palette growth reloads", difference.empty(), difference);
+	context.Report("palette growth moves the payload", ReadHeader(path).payloadOffset > oldOffset, "payload offset unchanged");
+	context.Report("palette growth leaves no temporary", !fs::exists(path.string() + ".tmp"), "temporary file left behind");
+}
+
+// Paging a level without writing it does not need write access
+void CheckReadOnly(CheckContext& context) {
+	fs::path path = context.directory / "readonly.lvl";
+	Level expected = MakeLevel(70, 70);
+	expected.SaveLevelBinary(path.string());
+	fs::permissions(path, fs::perms::owner_read | fs::perms::group_read | fs::perms::others_read);
+
+	ChunkedLevel chunked(32, 4);
+	bool isOpen = chunked.OpenBinary(path.string());
+	context.Report("read-only opens", isOpen && chunked.At(0, 0) == '#' && chunked.At(35, 35) == '.', "couldn't page the level");
+
+	fs::permissions(path, fs::perms::owner_read | fs::perms::owner_write);
+}
+
+// Headers whose payload would run past the end of the file are refused before any seek
+void CheckCorruptHeaders(CheckContext& context) {
+	fs::path path = context.directory / "corrupt.lvl";
+	MakeLevel(64, 64).SaveLevelBinary(path.string());
+	LevelHeader valid = ReadHeader(path);
+
+	LevelHeader header = valid;
+	header.payloadOffset = ~0ull - 16;
+	WriteHeader(path, header);
+	ChunkedLevel offsetLevel;
+	context.Report("offset past the end", !offsetLevel.OpenBinary(path.string()), "opened");
+
+	header = valid;
+	header.width = 0xFFFFFFFF;
+	header.height = 0xFFFFFFFF;
+	WriteHeader(path, header);
+	ChunkedLevel sizeLevel;
+	context.Report("payload past the end", !sizeLevel.OpenBinary(path.string()), "opened");
+
+	header = valid;
+	header.paletteSize = 0xFFFFFFF0;
+	WriteHeader(path, header);
+	ChunkedLevel paletteLevel;
+	context.Report("palette past the payload", !paletteLevel.OpenBinary(path.string()), "opened");
+}
+
+int main() {
+	CheckContext context;
+	context.directory = fs::temp_directory_path() / "LevelCheck";
+	fs::create_directories(context.directory);
+
+	CheckFlush(context);
+	CheckEviction(context);
+	CheckPaletteGrowth(context);
+	CheckReadOnly(context);
+	CheckCorruptHeaders(context);
+
+	fs::remove_all(context.directory);
+
+	std::cout << (context.nChecks - context.nFailed) << " of " << context.nChecks << " checks pass" << std::endl;
+	return context.nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,483 @@
+// Draws fixed scenes with the game's own renderers into a SoftwareSurface and compares them with golden
+// images, or measures the rasterizer's throughput. Needs sfml-graphics but no window or GPU:
+//   RenderCheck --golden tools/golden --update    write the golden images
+//   RenderCheck --golden tools/golden             compare; failures write <scene>.diff.png next to the golden
+//   RenderCheck --bench --seconds 0.5
+#include "../SoftwareSurface.h"
+#include "../GraphicsRender.h"
+#include "../TileBoard.h"
+#include "../WidgetTree.h"
+#include "../GraphicsUI.h"
+#include "../Random.h"
+#include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/Graphics/CircleShape.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <functional>
+
+struct CheckOptions {
+	std::string goldenDirectory;
+	bool isUpdate = false;
+	uint32_t tolerance = 0;
+	bool isBench = false;
+	double seconds = 0.5;
+};
+
+// Textures are only keys for the images bound to them, so nothing here needs a GL context
+struct SceneTextures {
+	sf::Texture checker, glyphs;
+	sf::Image checkerImage, glyphImage;
+
+	static const uint32_t GlyphWidth = 8, GlyphHeight = 12, GlyphCount = 8;
+
+	// A 16x16 two-colour checker with a translucent quarter, and a strip of white glyph-like coverage masks
+	SceneTextures() {
+		checkerImage.create(16, 16);
+		for (uint32_t y = 0; y < 16; y++) {
+			for (uint32_t x = 0; x < 16; x++) {
+				sf::Color color = ((x / 4 + y / 4) % 2) ? sf::Color(230, 200, 60) : sf::Color(40, 90, 200);
+				if (x >= 8 && y >= 8) color.a = 128;
+				checkerImage.setPixel(x, y, color);
+			}
+		}
+
+		glyphImage.create(GlyphWidth * GlyphCount, GlyphHeight, sf::Color::Transparent);
+		for (uint32_t g = 0; g < GlyphCount; g++) {
+			for (uint32_t y = 0; y < GlyphHeight; y++) {
+				for (uint32_t x = 0; x < GlyphWidth; x++) {
+					float dx = x + 0.5f - GlyphWidth / 2.0f, dy = y + 0.5f - GlyphHeight / 2.0f;
+					float ring = std::fabs(std::sqrt(dx * dx + dy * dy) - 1.0f - g * 0.5f);
+					uint8_t coverage = (uint8_t)(255.0f * (std::max)(0.0f, 1.0f - ring / 1.5f));
+					if (g % 3 == 0 && x == g % GlyphWidth) coverage = 255;
+					glyphImage.setPixel(g * GlyphWidth + x, y, sf::Color(255, 255, 255, coverage));
+				}
+			}
+		}
+	}
+
+	void Bind(SoftwareSurface& surface) const {
+		surface.BindTexture(checker, checkerImage);
+		surface.BindTexture(glyphs, glyphImage);
+	}
+};
+
+void AddTexturedQuad(std::vector<sf::Vertex>& vertices, float x, float y, float w, float h, const sf::FloatRect& uv, sf::Color color) {
+	vertices.emplace_back(sf::Vector2f(x, y), color, sf::Vector2f(uv.left, uv.top));
+	vertices.emplace_back(sf::Vector2f(x + w, y), color, sf::Vector2f(uv.left + uv.width, uv.top));
+	vertices.emplace_back(sf::Vector2f(x + w, y + h), color, sf::Vector2f(uv.left + uv.width, uv.top + uv.height));
+	vertices.emplace_back(sf::Vector2f(x, y + h), color, sf::Vector2f(uv.left, uv.top + uv.height));
+}
+
+sf::FloatRect GlyphRect(uint32_t g) {
+	return sf::FloatRect((float)(g % SceneTextures::GlyphCount * SceneTextures::GlyphWidth), 0.0f, (float)SceneTextures::GlyphWidth, (float)SceneTextures::GlyphHeight);
+}
+
+// Play screen: a 4x4 board with one tile hovered and one pressed, under the score bar
+void RenderBoardScene(SoftwareSurface& surface, const SceneTextures&) {
+	TileBoard board(4, 4, { 0.0f, 30.0f, 485.0f, 485.0f });
+	Random random(7);
+	for (uint32_t i = 0; i < board.GetTileCount(); i++) {
+		sf::Color color((uint8_t)random.Next(156), (uint8_t)random.Next(156), (uint8_t)random.Next(156));
+		board.SetColors(i, sf::Color(color.r + 100, color.g + 100, color.b + 100), sf::Color(color.r + 50, color.g + 50, color.b + 50), color);
+	}
+	board.ResetColors();
+
+	sf::Event e;
+	e.type = sf::Event::MouseMoved;
+	board.ManageEvent(e, { 180.0f, 160.0f });
+	e.type = sf::Event::MouseButtonPressed;
+	e.mouseButton.button = sf::Mouse::Left;
+	board.ManageEvent(e, { 300.0f, 420.0f });
+
+	WidgetTree widgets;
+	uint32_t scoreBox = widgets.Add(-1, { 0.0f, 0.0f }, { 485.0f, 30.0f }, sf::Color(60, 60, 60));
+	widgets.SetOutline(scoreBox, -2.0f, sf::Color(200, 200, 200));
+
+	surface.Clear(sf::Color(20, 20, 20));
+	board.Render(surface);
+	widgets.Render(surface);
+}
+
+// Menu-like nesting, outlines growing out and in, a translucent panel and a hidden node
+void RenderWidgetScene(SoftwareSurface& surface, const SceneTextures&) {
+	WidgetTree widgets;
+	uint32_t panel = widgets.Add(-1, { 40.0f, 60.0f }, { 405.0f, 400.0f }, sf::Color(255, 255, 255, 40));
+	widgets.SetOutline(panel, 3.0f, sf::Color(255, 255, 255, 160));
+
+	for (uint32_t i = 0; i < 3; i++) {
+		uint32_t button = widgets.Add((int32_t)panel, { 60.0f, 40.0f + i * 120.0f }, { 285.0f, 90.0f }, sf::Color(70 + i * 60, 120, 200 - i * 50));
+		widgets.SetOutline(button, i == 1 ? -6.0f : 2.0f, sf::Color(20, 20, 20, 200));
+		widgets.Add((int32_t)button, { 10.0f, 10.0f }, { 40.0f, 70.0f }, sf::Color(255, 255, 255, 90));
+	}
+
+	uint32_t hidden = widgets.Add((int32_t)panel, { 0.0f, 0.0f }, { 405.0f, 400.0f }, sf::Color::Red);
+	widgets.SetVisible(hidden, false);
+
+	surface.Clear(sf::Color(30, 30, 50));
+	widgets.Render(surface);
+}
+
+// The free Draw* helpers through a primitive batch, over translucent rects
+void RenderPrimitiveScene(SoftwareSurface& surface, const SceneTextures&) {
+	surface.Clear(sf::Color::Black);
+
+	PrimitiveBatch batch;
+	batch.Begin();
+	DrawGrid(surface, 32.0f, sf::Color(255, 255, 255, 50));
+	batch.AddRect(50.0f, 50.0f, 200.0f, 150.0f, sf::Color(255, 0, 0, 120));
+	batch.AddRect(150.5f, 120.25f, 200.0f, 150.0f, sf::Color(0, 255, 0, 120));
+	DrawLine(surface, 10.0f, 500.0f, 470.0f, 20.0f, sf::Color(255, 255, 0));
+	DrawLine(surface, 20.0f, 300.0f, 460.0f, 330.0f, sf::Color(0, 255, 255, 180));
+	DrawPolygon(surface, { { 240.0f, 330.0f }, { 330.0f, 390.0f }, { 300.0f, 490.0f }, { 180.0f, 490.0f }, { 150.0f, 390.0f } }, sf::Color(255, 128, 0));
+	DrawCircle(surface, { 360.0f, 140.0f }, 70.0f, sf::Color(200, 120, 255));
+	DrawPoint(surface, 10.0f, 10.0f);
+	batch.End(surface);
+}
+
+// sf::Shape and sf::Sprite decomposition, transforms, textures and per-vertex colours
+void RenderShapeScene(SoftwareSurface& surface, const SceneTextures& textures) {
+	surface.Clear(sf::Color(40, 40, 40));
+
+	sf::RectangleShape rotated({ 160.0f, 90.0f });
+	rotated.setOrigin(80.0f, 45.0f);
+	rotated.setPosition(140.0f, 110.0f);
+	rotated.setRotation(30.0f);
+	rotated.setFillColor(sf::Color(220, 80, 60));
+	rotated.setOutlineThickness(4.0f);
+	rotated.setOutlineColor(sf::Color(255, 255, 255, 200));
+	surface.Draw(rotated);
+
+	sf::CircleShape circle(70.0f, 40);
+	circle.setPosition(260.0f, 40.0f);
+	circle.setFillColor(sf::Color(60, 200, 120, 150));
+	circle.setOutlineThickness(-5.0f);
+	circle.setOutlineColor(sf::Color(0, 0, 0, 180));
+	surface.Draw(circle);
+
+	sf::RectangleShape textured({ 128.0f, 96.0f });
+	textured.setPosition(30.0f, 250.0f);
+	textured.setTexture(&textures.checker);
+	textured.setTextureRect({ 0, 0, 16, 16 });
+	surface.Draw(textured);
+
+	sf::Sprite sprite;
+	sprite.setTexture(textures.checker);
+	sprite.setTextureRect({ 0, 0, 16, 16 }); // The texture is never loaded, so its size is 0x0
+	sprite.setPosition(200.0f, 250.0f);
+	sprite.setScale(3.0f, 3.0f);
+	sprite.setColor(sf::Color(255, 255, 255, 200));
+	surface.Draw(sprite);
+
+	const sf::Vertex gradient[] = {
+		sf::Vertex({ 280.0f, 400.0f }, sf::Color::Red), sf::Vertex({ 470.0f, 300.0f }, sf::Color::Green), sf::Vertex({ 450.0f, 500.0f }, sf::Color(0, 0, 255, 100)),
+	};
+	surface.Draw(gradient, 3, sf::Triangles);
+
+	const sf::Vertex strip[] = {
+		sf::Vertex({ 20.0f, 420.0f }, sf::Color(255, 255, 255, 120)), sf::Vertex({ 40.0f, 500.0f }, sf::Color(255, 255, 255, 120)),
+		sf::Vertex({ 90.0f, 430.0f }, sf::Color(255, 255, 255, 120)), sf::Vertex({ 130.0f, 495.0f }, sf::Color(255, 255, 255, 120)),
+		sf::Vertex({ 200.0f, 410.0f }, sf::Color(255, 255, 255, 120)), sf::Vertex({ 240.0f, 505.0f }, sf::Color(255, 255, 255, 120)),
+	};
+	surface.Draw(strip, 6, sf::TriangleStrip);
+}
+
+// Glyph quads: coverage masks tinted by the text colour, one to one and scaled, over a gradient
+void RenderGlyphScene(SoftwareSurface& surface, const SceneTextures& textures) {
+	const sf::Vertex background[] = {
+		sf::Vertex({ 0.0f, 0.0f }, sf::Color(10, 10, 60)), sf::Vertex({ 485.0f, 0.0f }, sf::Color(10, 60, 10)),
+		sf::Vertex({ 485.0f, 515.0f }, sf::Color(60, 10, 10)), sf::Vertex({ 0.0f, 515.0f }, sf::Color(10, 10, 10)),
+	};
+	surface.Clear(sf::Color::Black);
+	surface.Draw(background, 4, sf::Quads);
+
+	std::vector<sf::Vertex> vertices;
+	const sf::Color colors[] = { sf::Color::White, sf::Color(255, 220, 80), sf::Color(120, 200, 255, 160) };
+	for (uint32_t line = 0; line < 12; line++) {
+		for (uint32_t g = 0; g < 50; g++) {
+			AddTexturedQuad(vertices, 12.0f + g * 9.0f, 10.0f + line * 16.0f, 8.0f, 12.0f, GlyphRect(g + line), colors[line % 3]);
+		}
+	}
+	for (uint32_t g = 0; g < 16; g++) {
+		AddTexturedQuad(vertices, 12.0f + (g % 8) * 58.0f, 220.0f + (g / 8) * 90.0f, 16.0f + g * 2.0f, 24.0f + g * 3.0f, GlyphRect(g), colors[g % 3]);
+	}
+
+	sf::RenderStates states(&textures.glyphs);
+	surface.Draw(vertices.data(), vertices.size(), sf::Quads, states);
+
+	sf::RenderStates moved(&textures.glyphs);
+	moved.transform.translate(0.25f, 420.5f);
+	surface.Draw(vertices.data(), 50 * 4, sf::Quads, moved);
+}
+
+// Sliders with plain and textured bars, one knob dragged along its bar, under the tree's other boxes
+void RenderSliderScene(SoftwareSurface& surface, const SceneTextures& textures) {
+	WidgetTree widgets;
+	uint32_t panel = widgets.Add(-1, { 30.0f, 40.0f }, { 425.0f, 300.0f }, sf::Color(50, 50, 70));
+	widgets.SetOutline(panel, 2.0f, sf::Color(150, 150, 170));
+
+	Slider plain(widgets, { 60.0f, 100.0f }, { 360.0f, 12.0f }, 14.0f, sf::Color(90, 90, 90), sf::Color(240, 120, 40));
+	Slider textured(widgets, { 60.0f, 200.0f }, { 360.0f, 20.0f }, 18.0f, sf::Color::Red, sf::Color(80, 200, 120, 200));
+	textured.SetTexture(textures.checker, sf::IntRect(0, 0, 16, 16));
+	Slider cropped(widgets, { 60.0f, 280.0f }, { 200.0f, 16.0f }, 10.0f, sf::Color::Red, sf::Color::White);
+	cropped.SetTexture(textures.checker, sf::IntRect(4, 4, 8, 8));
+
+	plain.Logic({ 65.0f, 105.0f });
+	plain.Logic({ 72.0f, 105.0f });
+	textured.Logic({ 300.0f, 210.0f }); // Outside the knob, stays put
+
+	surface.Clear(sf::Color(20, 20, 30));
+	widgets.Render(surface);
+	plain.Render(surface);
+	textured.Render(surface);
+	cropped.Render(surface);
+}
+
+// Text boxes without a font: box, selection tint and the cursor moved between lines. Glyph pixels
+// come from FreeType and would tie the golden to its version; the glyphs scene covers the quads
+void RenderTextBoxScene(SoftwareSurface& surface, const SceneTextures&) {
+	WidgetTree widgets;
+	TextBox single(widgets, { 40.0f, 40.0f }, { 405.0f, 50.0f }, sf::Color(40, 40, 40));
+	single.SetString("submit");
+
+	TextBox multiline(widgets, { 40.0f, 140.0f }, { 405.0f, 300.0f }, sf::Color(30, 60, 90));
+	multiline.SetMultiline(true);
+	multiline.SetCharacterSize(40);
+	multiline.SetString("one\ntwo\nthree\nfour");
+
+	sf::Event e;
+	e.type = sf::Event::MouseButtonPressed;
+	e.mouseButton.button = sf::Mouse::Left;
+	e.mouseButton.x = 200;
+	e.mouseButton.y = 150;
+	multiline.Logic(e);
+	e.type = sf::Event::KeyPressed;
+	e.key.code = sf::Keyboard::Down;
+	multiline.Logic(e);
+	multiline.Logic(e);
+
+	surface.Clear(sf::Color(15, 15, 15));
+	widgets.Render(surface);
+	single.Render(surface);
+	multiline.Render(surface);
+}
+
+struct Scene {
+	const char* name;
+	void (*render)(SoftwareSurface&, const SceneTextures&);
+};
+
+const Scene Scenes[] = {
+	{ "board", RenderBoardScene },
+	{ "widgets", RenderWidgetScene },
+	{ "primitives", RenderPrimitiveScene },
+	{ "shapes", RenderShapeScene },
+	{ "glyphs", RenderGlyphScene },
+	{ "slider", RenderSliderScene },
+	{ "textbox", RenderTextBoxScene },
+};
+
+bool CheckScenes(const CheckOptions& options) {
+	SceneTextures textures;
+	uint32_t nFailed = 0;
+
+	for (const Scene& scene : Scenes) {
+		SoftwareSurface surface(485, 515);
+		textures.Bind(surface);
+		scene.render(surface, textures);
+
+		std::string path = options.goldenDirectory + "/" + scene.name + ".png";
+		if (options.isUpdate) {
+			if (!surface.SaveToFile(path)) {
+				std::cout << "Couldn't write " << path << std::endl;
+				return false;
+			}
+			std::cout << "wrote  " << path << std::endl;
+			continue;
+		}
+
+		sf::Image golden, diff;
+		if (!golden.loadFromFile(path)) {
+			std::cout << "FAIL   " << scene.name << ": no golden image " << path << ", run with --update to write it" << std::endl;
+			nFailed++;
+			continue;
+		}
+
+		SoftwareSurface::ImageDiff result = surface.Compare(golden, (uint8_t)(std::min)(options.tolerance, 255u), &diff);
+		if (result.isSizeEqual && result.nDifferent == 0) {
+			std::cout << "ok     " << scene.name << " (max delta " << result.maxDelta << ")" << std::endl;
+			continue;
+		}
+
+		nFailed++;
+		if (!result.isSizeEqual) {
+			std::cout << "FAIL   " << scene.name << ": golden is " << golden.getSize().x << "x" << golden.getSize().y << std::endl;
+			continue;
+		}
+
+		std::string diffPath = options.goldenDirectory + "/" + scene.name + ".diff.png";
+		diff.saveToFile(diffPath);
+		std::cout << "FAIL   " << scene.name << ": " << result.nDifferent << " pixels differ, max delta " << result.maxDelta << ", see " << diffPath << std::endl;
+	}
+
+	if (!options.isUpdate) std::cout << (sizeof(Scenes) / sizeof(Scenes[0]) - nFailed) << " of " << sizeof(Scenes) / sizeof(Scenes[0]) << " scenes match" << std::endl;
+	return nFailed == 0;
+}
+
+// Calls draw until at least the given time has passed and returns the calls per second
+double Measure(double seconds, const std::function<void()>& draw) {
+	auto start = std::chrono::steady_clock::now();
+	uint64_t nCalls = 0;
+	double elapsed = 0.0;
+
+	do {
+		draw();
+		nCalls++;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (elapsed < seconds);
+
+	return nCalls / elapsed;
+}
+
+void RunBenchmarks(const CheckOptions& options) {
+	const uint32_t size = 1024, nPrimitives = 2000;
+	SoftwareSurface surface(size, size);
+	SceneTextures textures;
+	textures.Bind(surface);
+	Random random(1);
+
+	auto Position = [&](float margin) { return sf::Vector2f(random.NextFloat() * (size - margin), random.NextFloat() * (size - margin)); };
+	auto RandomColor = [&](uint8_t alpha) { return sf::Color((uint8_t)random.Next(256), (uint8_t)random.Next(256), (uint8_t)random.Next(256), alpha); };
+
+	auto Rects = [&](float side, uint8_t alpha) {
+		std::vector<sf::Vertex> vertices;
+		for (uint32_t i = 0; i < nPrimitives; i++) {
+			sf::Vector2f p = Position(side);
+			AddTexturedQuad(vertices, p.x, p.y, side, side, sf::FloatRect(), RandomColor(alpha));
+		}
+		return vertices;
+	};
+
+	// Right triangles with legs of 32 rotated by a random angle, 512 pixels each
+	auto Triangles = [&](bool isGradient) {
+		std::vector<sf::Vertex> vertices;
+		for (uint32_t i = 0; i < nPrimitives; i++) {
+			sf::Vector2f p = Position(96.0f) + sf::Vector2f(48.0f, 48.0f);
+			float angle = random.NextFloat() * 6.2831853f, c = 32.0f * std::cos(angle), s = 32.0f * std::sin(angle);
+			sf::Color color = RandomColor(160);
+			vertices.emplace_back(p, color);
+			vertices.emplace_back(sf::Vector2f(p.x + c, p.y + s), isGradient ? RandomColor(160) : color);
+			vertices.emplace_back(sf::Vector2f(p.x - s, p.y + c), isGradient ? RandomColor(160) : color);
+		}
+		return vertices;
+	};
+
+	auto TexturedQuads = [&](float side, const sf::FloatRect& uv) {
+		std::vector<sf::Vertex> vertices;
+		for (uint32_t i = 0; i < nPrimitives; i++) {
+			sf::Vector2f p = Position(side);
+			AddTexturedQuad(vertices, std::floor(p.x), std::floor(p.y), side, side, uv, sf::Color::White);
+		}
+		return vertices;
+	};
+
+	auto Glyphs = [&]() {
+		std::vector<sf::Vertex> vertices;
+		for (uint32_t i = 0; i < nPrimitives; i++) {
+			sf::Vector2f p = Position(16.0f);
+			AddTexturedQuad(vertices, std::floor(p.x), std::floor(p.y), (float)SceneTextures::GlyphWidth, (float)SceneTextures::GlyphHeight, GlyphRect(i), RandomColor(255));
+		}
+		return vertices;
+	};
+
+	auto Lines = [&]() {
+		std::vector<sf::Vertex> vertices;
+		for (uint32_t i = 0; i < nPrimitives; i++) {
+			sf::Vector2f p = Position(64.0f) + sf::Vector2f(32.0f, 32.0f);
+			float angle = random.NextFloat() * 6.2831853f;
+			sf::Color color = RandomColor(200);
+			vertices.emplace_back(p, color);
+			vertices.emplace_back(sf::Vector2f(p.x + 32.0f * std::cos(angle), p.y + 32.0f * std::sin(angle)), color);
+		}
+		return vertices;
+	};
+
+	auto Points = [&]() {
+		std::vector<sf::Vertex> vertices;
+		for (uint32_t i = 0; i < nPrimitives; i++) vertices.emplace_back(Position(1.0f), RandomColor(200));
+		return vertices;
+	};
+
+	struct Case {
+		std::string name;
+		std::vector<sf::Vertex> vertices;
+		sf::PrimitiveType type;
+		uint32_t verticesPerPrimitive;
+		double pixelsPerPrimitive;
+		const sf::Texture* texture;
+	};
+
+	std::vector<Case> cases = {
+		{ "opaque rects 64x64", Rects(64.0f, 255), sf::Quads, 4, 64.0 * 64.0, nullptr },
+		{ "blended rects 64x64", Rects(64.0f, 128), sf::Quads, 4, 64.0 * 64.0, nullptr },
+		{ "blended rects 8x8", Rects(8.0f, 128), sf::Quads, 4, 8.0 * 8.0, nullptr },
+		{ "flat triangles", Triangles(false), sf::Triangles, 3, 512.0, nullptr },
+		{ "gradient triangles", Triangles(true), sf::Triangles, 3, 512.0, nullptr },
+		{ "textured quads 16x16", TexturedQuads(16.0f, { 0.0f, 0.0f, 16.0f, 16.0f }), sf::Quads, 4, 16.0 * 16.0, &textures.checker },
+		{ "textured quads 64x64 x4", TexturedQuads(64.0f, { 0.0f, 0.0f, 16.0f, 16.0f }), sf::Quads, 4, 64.0 * 64.0, &textures.checker },
+		{ "glyph quads 8x12", Glyphs(), sf::Quads, 4, 8.0 * 12.0, &textures.glyphs },
+		{ "lines 32px", Lines(), sf::Lines, 2, 32.0, nullptr },
+		{ "points", Points(), sf::Points, 1, 1.0, nullptr },
+	};
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "surface " << size << "x" << size << ", SIMD " << (SOFTWARE_SURFACE_SIMD ? "on" : "off") << std::endl;
+
+	double clearsPerSecond = Measure(options.seconds, [&]() { surface.Clear(sf::Color::Black); });
+	std::cout << std::left << std::setw(26) << "clear" << std::right << std::setw(10) << clearsPerSecond / 1e3 << " k/s" << std::setw(10) << clearsPerSecond * size * size / 1e6 << " Mpixels/s" << std::endl;
+
+	for (const Case& c : cases) {
+		sf::RenderStates states(c.texture);
+		double drawsPerSecond = Measure(options.seconds, [&]() { surface.Draw(c.vertices.data(), c.vertices.size(), c.type, states); });
+		double primitivesPerSecond = drawsPerSecond * nPrimitives;
+
+		std::cout << std::left << std::setw(26) << c.name << std::right << std::setw(10) << primitivesPerSecond / 1e3 << " k/s" << std::setw(10) << primitivesPerSecond * c.pixelsPerPrimitive / 1e6 << " Mpixels/s" << std::endl;
+	}
+}
+
+bool ParseArguments(int argc, char** argv, CheckOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string name = argv[i];
+		if (name == "--update") options.isUpdate = true;
+		else if (name == "--bench") options.isBench = true;
+		else if (i + 1 >= argc) {
+			std::cout << "Missing value for " << name << std::endl;
+			return false;
+		}
+		else if (name == "--golden") options.goldenDirectory = argv[++i];
+		else if (name == "--tolerance") options.tolerance = (uint32_t)std::stoul(argv[++i]);
+		else if (name == "--seconds") options.seconds = std::stod(argv[++i]);
+		else {
+			std::cout << "Unknown option " << name << std::endl;
+			return false;
+		}
+	}
+
+	if (options.goldenDirectory.empty() && !options.isBench) {
+		std::cout << "Usage: RenderCheck [--golden DIR [--update] [--tolerance N]] [--bench [--seconds S]]" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv) {
+	CheckOptions options;
+	if (!ParseArguments(argc, argv, options)) return 1;
+
+	bool isPassed = options.goldenDirectory.empty() || CheckScenes(options);
+	if (options.isBench) RunBenchmarks(options);
+
+	return isPassed ? 0 : 1;
+}
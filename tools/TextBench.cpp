@@ -0,0 +1,103 @@
+// Compares per-frame text through the immediate RenderText/DrawTextWithValue helpers, which build an
+// sf::Text (and a stringstream for values) on every call, with their CachedText overloads. The surface
+// only asks each text for its bounds, which makes SFML lay out the glyphs as a draw would, so the
+// numbers are the text cost without rasterization. Needs sfml-graphics and a font, no window:
+//   TextBench --font files/fonts/Sansation_Bold.ttf --seconds 1 --change-every 30
+#include "../GraphicsRender.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <functional>
+
+struct BenchOptions {
+	std::string fontPath = "files/fonts/Sansation_Bold.ttf";
+	double seconds = 1.0;
+	uint32_t changeEvery = 30; // Frames between score changes
+};
+
+// Forces the glyph layout of every text without rasterizing it
+class LayoutSurface : public RenderSurface {
+public:
+	double width = 0.0; // Keeps the layout from being optimized away
+
+	sf::Vector2u GetSize() const override { return { 485, 515 }; }
+	void Clear(sf::Color) override {}
+
+	void Draw(const sf::Vertex*, std::size_t, sf::PrimitiveType, const sf::RenderStates&) override {}
+	void Draw(const sf::Shape&, const sf::RenderStates&) override {}
+	void Draw(const sf::Sprite&, const sf::RenderStates&) override {}
+	void Draw(const sf::Text& text, const sf::RenderStates&) override { width += text.getLocalBounds().width; }
+};
+
+// Calls frame with an increasing frame number until at least the given time has passed and returns the frames per second
+double Measure(double seconds, const std::function<void(uint64_t)>& frame) {
+	auto start = std::chrono::steady_clock::now();
+	uint64_t nFrames = 0;
+	double elapsed = 0.0;
+
+	do {
+		frame(nFrames);
+		nFrames++;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (elapsed < seconds);
+
+	return nFrames / elapsed;
+}
+
+// A menu's three static labels and a score label whose value changes every changeEvery frames
+void RunBenchmarks(const BenchOptions& options, const sf::Font& font) {
+	const char* labels[] = { "Play", "Options", "Quit" };
+	const uint32_t nLabels = sizeof(labels) / sizeof(labels[0]);
+	LayoutSurface surface;
+
+	double immediate = Measure(options.seconds, [&](uint64_t frame) {
+		for (uint32_t i = 0; i < nLabels; i++) RenderText(surface, font, 180.0f, 100.0f + i * 100.0f, labels[i]);
+		DrawTextWithValue(surface, font, 5.0f, 0.0f, "Score:", (float)(frame / options.changeEvery), sf::Color::White, 24);
+	});
+
+	CachedText labelTexts[nLabels], scoreText;
+	double cached = Measure(options.seconds, [&](uint64_t frame) {
+		for (uint32_t i = 0; i < nLabels; i++) RenderText(surface, labelTexts[i], font, 180.0f, 100.0f + i * 100.0f, labels[i]);
+		DrawTextWithValue(surface, scoreText, font, 5.0f, 0.0f, "Score:", (float)(frame / options.changeEvery), sf::Color::White, 24);
+	});
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << nLabels << " static labels and a score changing every " << options.changeEvery << " frames" << std::endl;
+	std::cout << std::left << std::setw(12) << "immediate" << std::right << std::setw(10) << 1e6 / immediate << " us/frame" << std::endl;
+	std::cout << std::left << std::setw(12) << "cached" << std::right << std::setw(10) << 1e6 / cached << " us/frame" << std::endl;
+	std::cout << "speed-up " << cached / immediate << "x (layout width " << surface.width << ")" << std::endl;
+}
+
+bool ParseArguments(int argc, char** argv, BenchOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string name = argv[i];
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << name << std::endl;
+			return false;
+		}
+		else if (name == "--font") options.fontPath = argv[++i];
+		else if (name == "--seconds") options.seconds = std::stod(argv[++i]);
+		else if (name == "--change-every") options.changeEvery = (std::max)(1u, (uint32_t)std::stoul(argv[++i]));
+		else {
+			std::cout << "Usage: TextBench [--font FILE] [--seconds S] [--change-every FRAMES]" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv) {
+	BenchOptions options;
+	if (!ParseArguments(argc, argv, options)) return 1;
+
+	sf::Font font;
+	if (!font.loadFromFile(options.fontPath)) {
+		std::cout << "Couldn't load " << options.fontPath << std::endl;
+		return 1;
+	}
+
+	RunBenchmarks(options, font);
+	return 0;
+}
@@ -0,0 +1,106 @@
+// Measures tile sound trigger latency, from the press to the return of play(), for a burst of presses
+// on random tiles: once through the single sf::Sound the play state used to have, which looked the
+// buffer up by name and called setBuffer on every press, and once through VoicePool. Needs sfml-audio
+// and an audio device; run from the game directory:
+//   VoiceBench --presses 2000 --interval-ms 0 --seed 1
+#include "../AssetManager.h"
+#include "../VoicePool.h"
+#include "../Random.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <thread>
+
+struct BenchOptions {
+	uint32_t nPresses = 2000;
+	uint32_t intervalMs = 0; // Time between presses; 0 is a burst
+	uint64_t seed = 1;
+};
+
+const char* SoundNames[] = { "beep1", "beep2", "beep3", "beep4" };
+const uint32_t SoundCount = sizeof(SoundNames) / sizeof(SoundNames[0]);
+
+void PrintStats(const char* name, const VoicePool::LatencyStats& stats) {
+	std::cout << std::left << std::setw(14) << name << std::right << std::setw(8) << stats.count << " presses, average "
+		<< std::setw(8) << stats.averageMicroseconds << " us, max " << std::setw(8) << stats.maxMicroseconds << " us" << std::endl;
+}
+
+bool ParseArguments(int argc, char** argv, BenchOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string name = argv[i];
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << name << std::endl;
+			return false;
+		}
+		else if (name == "--presses") options.nPresses = (uint32_t)std::stoul(argv[++i]);
+		else if (name == "--interval-ms") options.intervalMs = (uint32_t)std::stoul(argv[++i]);
+		else if (name == "--seed") options.seed = std::stoull(argv[++i]);
+		else {
+			std::cout << "Usage: VoiceBench [--presses N] [--interval-ms MS] [--seed N]" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv) {
+	BenchOptions options;
+	if (!ParseArguments(argc, argv, options)) return 1;
+
+	AssetHolder& holder = AssetHolder::Get();
+	for (uint32_t i = 0; i < SoundCount; i++) holder.AddSoundBuffer(SoundNames[i], std::string("files/sounds/") + SoundNames[i] + ".wav");
+	if (!holder.WaitAll().empty()) return 1;
+
+	std::vector<uint32_t> presses(options.nPresses);
+	Random random(options.seed);
+	for (auto& tile : presses) tile = random.Next(SoundCount);
+
+	auto Wait = [&]() {
+		if (options.intervalMs) std::this_thread::sleep_for(std::chrono::milliseconds(options.intervalMs));
+	};
+
+	// The old play state: one voice, the buffer found by name on every press
+	sf::Sound sound;
+	uint64_t count = 0;
+	double sum = 0.0, max = 0.0;
+	for (uint32_t tile : presses) {
+		auto eventTime = std::chrono::steady_clock::now();
+		switch (tile) {
+		case 0:
+			sound.setBuffer(holder.GetSoundBuffer("beep1"));
+			break;
+		case 1:
+			sound.setBuffer(holder.GetSoundBuffer("beep2"));
+			break;
+		case 2:
+			sound.setBuffer(holder.GetSoundBuffer("beep3"));
+			break;
+		case 3:
+			sound.setBuffer(holder.GetSoundBuffer("beep4"));
+			break;
+		}
+		sound.play();
+
+		double latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - eventTime).count();
+		count++;
+		sum += latency;
+		max = (std::max)(max, latency);
+		Wait();
+	}
+	sound.stop();
+
+	VoicePool voices;
+	for (uint32_t i = 0; i < SoundCount; i++) voices.Bind(holder.GetSoundBuffer(SoundNames[i]));
+	for (uint32_t tile : presses) {
+		voices.Play(tile, std::chrono::steady_clock::now());
+		Wait();
+	}
+	voices.StopAll();
+
+	std::cout << std::fixed << std::setprecision(2);
+	PrintStats("single sound", { count, count ? sum / count : 0.0, max });
+	PrintStats("voice pool", voices.GetLatencyStats());
+	return 0;
+}